@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ast_binary.hpp"
+#include "ast_vm.hpp"
+#include "ast_writer.hpp"
+#include "syntax_analyzer.hpp"
+#include "random_expr.hpp"
+
+// Cost of building, dumping and freeing ASTs in the different representations
+// Usage: ast_bench [EXPRESSIONS]
+
+using Clock = std::chrono::steady_clock;
+
+static void report(const char *name, std::size_t items, double seconds) {
+    std::cout << std::setw(16) << name << std::setw(14) << std::size_t(items / seconds) << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::mt19937 rng(42);
+
+    std::vector<std::string> exprs;
+    for (int i = 0; i < count; i++) exprs.push_back(random_expr(rng, 8));
+
+    ParseTables tables;
+    if (tables.init()) return EXIT_FAILURE;
+
+    std::cout << std::setw(16) << "parse + free" << std::setw(14) << "exprs/s" << "\n";
+    const std::pair<Parser::AstStorage, const char*> storages[] = {
+        {Parser::AstStorage::SHARED, "shared_ptr"},
+        {Parser::AstStorage::ARENA, "arena"},
+        {Parser::AstStorage::POSTFIX, "postfix"},
+        {Parser::AstStorage::DAG, "dag"},
+    };
+    for (auto [storage, name]: storages) {
+        Parser parser(tables);
+        parser.set_ast_storage(storage);
+
+        auto start = Clock::now();
+        for (const std::string& expr: exprs) {
+            if (parser.parse_view(expr) != Parser::ParseStatus::SUCCESS) return EXIT_FAILURE;
+        }
+        report(name, exprs.size(), std::chrono::duration<double>(Clock::now() - start).count());
+        if (storage == Parser::AstStorage::DAG) {
+            const AST::DagBuilder& dag = parser.get_dag_builder();
+            std::cout << std::setw(16) << "" << "  " << dag.size() << " of " << dag.requested() << " nodes kept\n";
+        }
+    }
+
+    // the same 1000 expressions over and over
+    std::cout << "\n" << std::setw(16) << "repeated feed" << std::setw(14) << "exprs/s" << "\n";
+    for (auto [storage, name]: {storages[0], storages[3]}) {
+        Parser parser(tables);
+        parser.set_ast_storage(storage);
+        std::vector<AST::NodePtr> roots; // kept, as a consumer storing results would
+
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < exprs.size(); i++) {
+            parser.parse_view(exprs[i % 1000]);
+            roots.push_back(parser.get_root());
+        }
+        report(name, exprs.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    std::cout << "\n" << std::setw(16) << "parse + dump" << std::setw(14) << "exprs/s" << "\n";
+    for (auto [storage, name]: std::span(storages, 2)) {
+        Parser parser(tables);
+        parser.set_ast_storage(storage);
+        std::ostringstream out;
+
+        auto start = Clock::now();
+        for (const std::string& expr: exprs) {
+            parser.parse_view(expr);
+            out.str("");
+            if (storage == Parser::AstStorage::ARENA) AST::dumpTreeAsString(parser.get_tree(), out);
+            else AST::dumpTreeAsString(parser.get_root(), out);
+        }
+        report(name, exprs.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    for (auto [storage, name]: {std::pair(Parser::AstStorage::SHARED, "shared writer"),
+                                std::pair(Parser::AstStorage::ARENA, "arena writer")}) {
+        Parser parser(tables);
+        parser.set_ast_storage(storage);
+        AST::TextWriter out;
+
+        auto start = Clock::now();
+        for (const std::string& expr: exprs) {
+            parser.parse_view(expr);
+            out.clear();
+            if (storage == Parser::AstStorage::ARENA) out.write(parser.get_tree(), AST::SERIALIZE);
+            else out.write(parser.get_root(), AST::SERIALIZE);
+        }
+        report(name, exprs.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    // serialized forms of the same trees
+    std::vector<AST::NodePtr> roots;
+    {
+        Parser parser(tables);
+        for (const std::string& expr: exprs) {
+            parser.parse_view(expr);
+            roots.push_back(parser.get_root());
+        }
+    }
+    std::size_t text_size = 0;
+    std::vector<std::vector<std::uint8_t>> images(roots.size());
+    std::cout << "\n" << std::setw(16) << "write" << std::setw(14) << "exprs/s" << "\n";
+    {
+        std::ostringstream out;
+        auto start = Clock::now();
+        for (const AST::NodePtr& root: roots) {
+            out.str("");
+            AST::dumpTreeAsString(root, out);
+            text_size += out.view().size();
+        }
+        report("text", roots.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    for (auto [type, name]: {std::pair(AST::SERIALIZE, "text writer"), std::pair(AST::GRAPHVIZ, "dot writer")}) {
+        // one stream of all trees, passed on in blocks
+        std::ostringstream sink;
+        auto start = Clock::now();
+        {
+            AST::TextWriter out(&sink);
+            for (const AST::NodePtr& root: roots) out.write(root, type);
+        }
+        report(name, roots.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    {
+        std::ostringstream sink;
+        auto start = Clock::now();
+        for (const AST::NodePtr& root: roots) AST::dumpTreeAsGraphviz(root, sink);
+        report("dot", roots.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    {
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < roots.size(); i++) AST::write_binary(roots[i], images[i]);
+        report("binary", roots.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    std::size_t binary_size = 0;
+    for (const auto& image: images) binary_size += image.size();
+    std::cout << std::setw(16) << "" << "  " << text_size << " text bytes, " << binary_size << " binary bytes\n";
+
+    std::cout << "\n" << std::setw(16) << "read binary" << std::setw(14) << "exprs/s" << "\n";
+    {
+        AST::BinaryReader reader;
+        std::size_t nodes = 0;
+        auto start = Clock::now();
+        for (const auto& image: images) {
+            if (reader.open(image)) return EXIT_FAILURE;
+            reader.walk([&](const AST::BinaryNode&) { nodes++; }, [](const AST::BinaryNode&, AST::Side) {});
+        }
+        report("walk in place", images.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    {
+        AST::BinaryReader reader;
+        auto start = Clock::now();
+        for (const auto& image: images) {
+            if (reader.open(image)) return EXIT_FAILURE;
+            AST::NodePtr root = reader.to_node();
+        }
+        report("to_node", images.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    // every expression evaluated over and over with different variables
+    const std::size_t n_exprs = std::min<std::size_t>(roots.size(), 1000), n_bindings = 200;
+    std::vector<std::vector<std::int32_t>> bindings(n_bindings, std::vector<std::int32_t>(26));
+    for (auto& values: bindings) {
+        for (std::int32_t& value: values) value = std::int32_t(rng() % 2000) - 1000;
+    }
+    std::cout << "\n" << std::setw(16) << "evaluate" << std::setw(14) << "evals/s" << "\n";
+    {
+        std::int64_t sum = 0;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < n_exprs; i++) {
+            for (const auto& values: bindings) {
+                auto value = AST::fold<std::optional<std::int32_t>>(roots[i], AST::Overloaded{
+                    [](const AST::BinOpNode& binop, std::optional<std::int32_t> left,
+                       std::optional<std::int32_t> right) -> std::optional<std::int32_t> {
+                        if (!left || !right) return std::nullopt;
+                        std::uint32_t l = *left, r = *right;
+                        switch (binop.op) {
+                            case AST::PLUS: return std::int32_t(l + r);
+                            case AST::MINUS: return std::int32_t(l - r);
+                            case AST::MUL: return std::int32_t(l * r);
+                            default:
+                                if (r == 0) return std::nullopt;
+                                return *right == -1 ? std::int32_t(0u - l) : *left / *right;
+                        }
+                    },
+                    // variables are looked up by name, as a tree walk without a slot table would
+                    [&](const AST::IdNode& id) -> std::optional<std::int32_t> { return values[id.name()[0] - 'a']; },
+                    [](const AST::NumNode& num) -> std::optional<std::int32_t> { return num.num; },
+                });
+                sum += value.value_or(0);
+            }
+        }
+        report("tree walk", n_exprs * n_bindings, std::chrono::duration<double>(Clock::now() - start).count());
+        std::cout << std::setw(16) << "" << "  checksum " << sum << "\n";
+    }
+    {
+        std::vector<AST::Program> programs(n_exprs);
+        for (std::size_t i = 0; i < n_exprs; i++) {
+            if (AST::compile(roots[i], programs[i])) return EXIT_FAILURE;
+        }
+
+        AST::Evaluator evaluator;
+        evaluator.set_error_stream(nullptr);
+        std::vector<std::int32_t> slot_values, sources;
+        std::int64_t sum = 0;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < n_exprs; i++) {
+            const AST::Program& program = programs[i];
+            // where each slot takes its value from, found once per expression
+            sources.clear();
+            for (std::uint32_t slot = 0; slot < program.slots(); slot++) sources.push_back(program.slot_name(slot)[0] - 'a');
+            slot_values.resize(program.slots());
+
+            for (const auto& values: bindings) {
+                for (std::uint32_t slot = 0; slot < program.slots(); slot++) slot_values[slot] = values[sources[slot]];
+                std::int32_t result = 0;
+                if (evaluator.run(program, slot_values, result) == AST::Evaluator::Status::SUCCESS) sum += result;
+            }
+        }
+        report("bytecode", n_exprs * n_bindings, std::chrono::duration<double>(Clock::now() - start).count());
+        std::cout << std::setw(16) << "" << "  checksum " << sum << "\n";
+
+        // bindings already in slot order, only the runs are measured
+        std::vector<std::vector<std::int32_t>> slot_bindings(n_exprs);
+        for (std::size_t i = 0; i < n_exprs; i++) {
+            for (const auto& values: bindings) {
+                for (std::uint32_t slot = 0; slot < programs[i].slots(); slot++) {
+                    slot_bindings[i].push_back(values[programs[i].slot_name(slot)[0] - 'a']);
+                }
+            }
+        }
+        auto binding = [&](std::size_t i, std::size_t k) {
+            return std::span(slot_bindings[i]).subspan(k * programs[i].slots(), programs[i].slots());
+        };
+        start = Clock::now();
+        for (std::size_t i = 0; i < n_exprs; i++) {
+            for (std::size_t k = 0; k < n_bindings; k++) {
+                std::int32_t result = 0;
+                if (evaluator.run(programs[i], binding(i, k), result) == AST::Evaluator::Status::SUCCESS) sum += result;
+            }
+        }
+        report("bytecode run", n_exprs * n_bindings, std::chrono::duration<double>(Clock::now() - start).count());
+
+        // a different expression every run, so jumps between handlers are not predicted
+        start = Clock::now();
+        for (std::size_t k = 0; k < n_bindings; k++) {
+            for (std::size_t i = 0; i < n_exprs; i++) {
+                std::int32_t result = 0;
+                if (evaluator.run(programs[i], binding(i, k), result) == AST::Evaluator::Status::SUCCESS) sum += result;
+            }
+        }
+        report("mixed run", n_exprs * n_bindings, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    return EXIT_SUCCESS;
+}
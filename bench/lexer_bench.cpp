@@ -0,0 +1,126 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "direct_lexer.hpp"
+#include "input_file.hpp"
+#include "parallel_parser.hpp"
+#include "syntax_analyzer.hpp"
+#include "random_expr.hpp"
+
+// Tokenizing and parsing throughput of the flex lexer against DirectLexer,
+// tokenizing a file through std::ifstream against the mapped file,
+// and parsing with tokens converted on the fly against a token buffer filled first
+// Usage: lexer_bench [EXPRESSIONS]
+
+using Clock = std::chrono::steady_clock;
+
+static void report(const char *name, std::size_t bytes, std::size_t items, double seconds) {
+    std::cout << std::setw(14) << name
+              << std::setw(14) << std::size_t(items / seconds)
+              << std::setw(10) << std::fixed << std::setprecision(1) << bytes / seconds / 1e6 << "\n";
+}
+
+template <typename Lexer>
+static std::size_t count_tokens(Lexer& lexer) {
+    std::size_t count = 0;
+    while (lexer.next_tok().type_ != TokenType::END) count++;
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::mt19937 rng(42);
+
+    // longer lexemes and blanks, so scanning matters more than in the other benchmarks
+    const ExprStyle style{100000, 12, true};
+    std::vector<std::string> exprs;
+    std::string text;
+    for (int i = 0; i < count; i++) {
+        exprs.push_back(random_expr(rng, 6, style));
+        text += exprs.back();
+        text += '\n';
+    }
+
+    std::cout << std::setw(14) << "" << std::setw(14) << "tokens/s" << std::setw(10) << "MB/s" << "\n";
+    {
+        std::istringstream in(text);
+        mathLexer lexer;
+        lexer.restart(in);
+        auto start = Clock::now();
+        std::size_t tokens = count_tokens(lexer);
+        report("flex", text.size(), tokens, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    {
+        DirectLexer lexer;
+        lexer.restart(text);
+        auto start = Clock::now();
+        std::size_t tokens = count_tokens(lexer);
+        report("direct", text.size(), tokens, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    const std::string path = "lexer_bench_input.txt";
+    std::ofstream(path, std::ios::binary) << text;
+
+    std::cout << "\n" << std::setw(14) << "file" << std::setw(14) << "tokens/s" << std::setw(10) << "MB/s" << "\n";
+    {
+        auto start = Clock::now();
+        std::ifstream in(path, std::ios::binary);
+        mathLexer lexer;
+        lexer.restart(in);
+        std::size_t tokens = count_tokens(lexer);
+        report("flex ifstream", text.size(), tokens, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    {
+        auto start = Clock::now();
+        SLR::InputFile file;
+        if (file.open(path)) return EXIT_FAILURE;
+        DirectLexer lexer;
+        lexer.restart(file.view());
+        std::size_t tokens = count_tokens(lexer);
+        report("direct mmap", text.size(), tokens, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    std::filesystem::remove(path);
+
+    ParseTables tables;
+    if (tables.init()) return EXIT_FAILURE;
+
+    std::cout << "\n" << std::setw(14) << "" << std::setw(14) << "exprs/s" << std::setw(10) << "MB/s" << "\n";
+    const std::pair<Parser::LexerBackend, const char*> backends[] = {
+        {Parser::LexerBackend::FLEX, "flex parse"},
+        {Parser::LexerBackend::DIRECT, "direct parse"},
+        {Parser::LexerBackend::TOKEN_BUFFER, "buffer parse"},
+    };
+    for (auto [backend, name]: backends) {
+        Parser parser(tables);
+        parser.set_lexer_backend(backend);
+
+        auto start = Clock::now();
+        for (const std::string& expr: exprs) {
+            if (parser.parse_view(expr) != Parser::ParseStatus::SUCCESS) return EXIT_FAILURE;
+        }
+        report(name, text.size(), exprs.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    // lexing interleaved with parsing on one thread against the two-thread pipeline
+    std::cout << "\n" << std::setw(14) << "lines" << std::setw(14) << "lines/s" << std::setw(10) << "MB/s" << "\n";
+    {
+        auto start = Clock::now();
+        LineResults results = parse_lines(tables, text, 1);
+        report("interleaved", text.size(), results.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    {
+        auto start = Clock::now();
+        LineResults results = parse_lines_pipelined(tables, text);
+        report("pipelined", text.size(), results.size(), std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    return EXIT_SUCCESS;
+}
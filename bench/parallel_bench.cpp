@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "parallel_parser.hpp"
+#include "random_expr.hpp"
+
+// Throughput of parse_lines for growing thread counts
+// Usage: parallel_bench [LINES]
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::mt19937 rng(42);
+
+    std::string text;
+    for (int i = 0; i < count; i++) {
+        text += random_expr(rng, 6);
+        text += '\n';
+    }
+
+    ParseTables tables;
+    if (tables.init()) return EXIT_FAILURE;
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "lines/s"
+              << std::setw(10) << "MB/s" << std::setw(10) << "speedup" << "\n";
+
+    double base = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        auto start = Clock::now();
+        LineResults results = parse_lines(tables, text, threads);
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        if (results.size() != std::size_t(count)) return EXIT_FAILURE;
+
+        double rate = count / elapsed.count();
+        if (threads == 1) base = rate;
+        std::cout << std::setw(8) << threads << std::setw(14) << std::fixed << std::setprecision(0) << rate
+                  << std::setw(10) << std::setprecision(2) << text.size() / elapsed.count() / 1e6
+                  << std::setw(10) << rate / base << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+// @brief How random_expr spells its leaves and operators
+struct ExprStyle {
+    unsigned max_number = 1000;  // numbers are below it
+    unsigned max_name = 1;       // identifiers are 1..max_name copies of one letter
+    bool spaces = false;         // blanks around binary operators
+};
+
+/// @brief Random valid expression of the built-in grammar, at most depth levels of nesting.
+/// Depends only on the rng state and style, so benchmarks with one seed see the same input
+inline std::string random_expr(std::mt19937& rng, int depth, const ExprStyle& style = {}) {
+    std::uniform_int_distribution<int> pick(0, 9);
+    int kind = depth > 0 ? pick(rng) : pick(rng) % 2;
+    switch (kind) {
+        case 0: return std::to_string(rng() % style.max_number);
+        case 1: {
+            std::size_t length = style.max_name > 1 ? 1 + rng() % style.max_name : 1;
+            return std::string(length, 'a' + rng() % 26);
+        }
+        case 2: return "(" + random_expr(rng, depth - 1, style) + ")";
+        default: {
+            std::string left = random_expr(rng, depth - 1, style);
+            char op = "+-*/"[rng() % 4];
+            std::string right = random_expr(rng, depth - 1, style);
+            return style.spaces ? left + " " + op + " " + right : left + op + right;
+        }
+    }
+}
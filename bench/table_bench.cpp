@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "syntax_analyzer.hpp"
+#include "random_expr.hpp"
+
+// Parse throughput of dense and compressed table layouts,
+// and time to build tables for growing grammars (LR(0) sets and FIRST/FOLLOW are bitsets)
+// Usage: table_bench [EXPRESSIONS]
+
+using Clock = std::chrono::steady_clock;
+using TableLayout = SyntaxAnalyzer::TableLayout;
+
+static std::string keyword(int i) {
+    std::string name = "kw";
+    for (; i; i /= 26) name += char('a' + i % 26);
+    return name;
+}
+
+static void reducePair(ValueStack& ast, const ReduceContext& ctx) {
+    reduceNumId(ast, ctx);
+    ast.erase(ast.end() - 2); // keyword
+}
+
+// S -> X0 | ... ; Xi -> 'kwi' id | 'kwi' num, table is almost all ERROR cells
+static std::string keyword_grammar(int n_keywords) {
+    std::ostringstream bnf;
+    bnf << "S -> X0";
+    for (int i = 1; i < n_keywords; i++) bnf << " | X" << i;
+    bnf << " ;\n";
+    for (int i = 0; i < n_keywords; i++) {
+        bnf << "X" << i << " -> '" << keyword(i) << "' id @pair | '" << keyword(i) << "' num @pair ;\n";
+    }
+    return bnf.str();
+}
+
+static int build(int n_keywords) {
+    SyntaxAnalyzer parser;
+    parser.bind_action("pair", reducePair);
+    std::istringstream bnf(keyword_grammar(n_keywords));
+    if (parser.load_grammar(bnf)) return -1;
+
+    auto start = Clock::now();
+    if (parser.init(SyntaxAnalyzer::TableSource::RUNTIME, SyntaxAnalyzer::Lookahead::LALR)) return -1;
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::cout << std::setw(10) << n_keywords << std::setw(10) << parser.table_stats().states
+              << std::setw(12) << std::fixed << std::setprecision(1) << elapsed.count() * 1e3 << "\n";
+    return 0;
+}
+
+struct Workload {
+    std::string name;
+    std::string grammar; // empty for the built-in grammar
+    std::vector<std::string> inputs;
+};
+
+static int run(const Workload& work, TableLayout layout) {
+    SyntaxAnalyzer parser;
+    parser.bind_action("pair", reducePair);
+    if (!work.grammar.empty()) {
+        std::istringstream bnf(work.grammar);
+        if (parser.load_grammar(bnf)) return -1;
+    }
+
+    auto source = work.grammar.empty() ? SyntaxAnalyzer::TableSource::COMPILED
+                                       : SyntaxAnalyzer::TableSource::RUNTIME;
+    if (parser.init(source, SyntaxAnalyzer::Lookahead::SLR) || parser.set_table_layout(layout)) return -1;
+
+    std::size_t bytes = 0;
+    for (const std::string& input: work.inputs) bytes += input.size();
+
+    auto start = Clock::now();
+    for (const std::string& input: work.inputs) {
+        if (parser.parse(input) != SyntaxAnalyzer::ParseStatus::SUCCESS) return -1;
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    const auto& stats = parser.table_stats();
+    bool compressed = layout == TableLayout::COMPRESSED;
+    std::cout << std::left << std::setw(12) << work.name
+              << std::setw(12) << (compressed ? "compressed" : "dense")
+              << std::right << std::setw(8) << stats.states
+              << std::setw(12) << (compressed ? stats.compressed_bytes : stats.dense_bytes)
+              << std::setw(14) << std::fixed << std::setprecision(0) << work.inputs.size() / elapsed.count()
+              << std::setw(10) << std::setprecision(2) << bytes / elapsed.count() / 1e6 << "\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::mt19937 rng(42);
+
+    Workload expr{"expr", "", {}};
+    for (int i = 0; i < count; i++) expr.inputs.push_back(random_expr(rng, 6));
+
+    const int n_keywords = 500;
+    Workload keywords{"keywords", keyword_grammar(n_keywords), {}};
+    for (int i = 0; i < count; i++) {
+        keywords.inputs.push_back(keyword(rng() % n_keywords) + " " + std::to_string(rng() % 1000));
+    }
+
+    std::cout << std::left << std::setw(12) << "grammar" << std::setw(12) << "layout"
+              << std::right << std::setw(8) << "states" << std::setw(12) << "bytes"
+              << std::setw(14) << "exprs/s" << std::setw(10) << "MB/s" << "\n";
+
+    for (const Workload& work: {expr, keywords}) {
+        for (TableLayout layout: {TableLayout::DENSE, TableLayout::COMPRESSED}) {
+            if (run(work, layout)) {
+                std::cerr << "Benchmark '" << work.name << "' failed\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // LALR(1) also propagates lookaheads, so every set operation of the construction is used
+    std::cout << "\n" << std::setw(10) << "keywords" << std::setw(10) << "states" << std::setw(12) << "build ms" << "\n";
+    for (int n: {250, 500, 1000, 2000}) {
+        if (build(n)) {
+            std::cerr << "Building tables for " << n << " keywords failed\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
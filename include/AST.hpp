@@ -1,7 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "symbol_table.hpp"
+
 namespace AST {
 
     enum DumpType {GRAPHVIZ = 0, SERIALIZE};
@@ -9,20 +19,26 @@ namespace AST {
     using NodePtr = std::shared_ptr<Node>;
     using WeakNodePtr = std::weak_ptr<Node>;
 
+    // closed set of node types, Node::kind tells which one a node is
+    enum class NodeKind : std::uint8_t { BINOP, ID, NUM };
+
+    // @brief Common part of all nodes. Nodes have no virtual functions:
+    // passes over the tree dispatch on kind with visit() or fold()
+    // Nodes don't know their parents: the same subtree may be shared by several
+    // parents (see DagBuilder), ParentMap finds them when needed
     struct Node {
         std::size_t id;
-        WeakNodePtr parent;
+        std::size_t hash = 0; // structural: equal subtrees have equal hashes, set by make*()
+        const NodeKind kind;
 
     protected:
-        Node(): id(++next_id) {}
+        explicit Node(NodeKind kind): id(new_id()), kind(kind) {}
+        // nodes are deleted as their own type by shared_ptr
+        ~Node() = default;
 
     public:
-
-        virtual void dump(std::ostream& os, DumpType type = GRAPHVIZ) = 0;
-        virtual ~Node() = default;
-
-    private:
-        static std::size_t next_id;
+        // unique across threads, increasing within a thread
+        static std::size_t new_id();
     };
 
 
@@ -30,37 +46,144 @@ namespace AST {
         PLUS, MINUS, MUL, DIV
     };
 
+    /// @brief Character of op in tree dumps, '?' for values outside the enum
+    char label(Operator op);
+
     struct BinOpNode final : Node {
         NodePtr left;
         NodePtr right;
         Operator op;
 
-        void dump(std::ostream& os, DumpType type = GRAPHVIZ) override;
-
-        ~BinOpNode() override = default;
+        BinOpNode(): Node(NodeKind::BINOP) {}
+        // frees the subtree with an explicit stack, so deep trees don't overflow the native stack
+        ~BinOpNode();
     };
 
     NodePtr makeBinOp(NodePtr left, Operator op, NodePtr right);
 
     struct IdNode final : Node {
-        std::string id_name;
+        std::uint32_t name_id; // in symbols(), equal names have equal ids
 
-        void dump(std::ostream& os, DumpType type = GRAPHVIZ) override;
-        ~IdNode() override = default;
+        IdNode(): Node(NodeKind::ID) {}
+
+        std::string_view name() const { return symbols().name(name_id); }
     };
 
-    NodePtr makeId(const std::string& name);
+    NodePtr makeId(std::uint32_t name_id);
+    NodePtr makeId(std::string_view name);
 
     struct NumNode final: Node {
         int num;
 
-        void dump(std::ostream& os, DumpType type = GRAPHVIZ) override;
-
-        ~NumNode() override = default;
+        NumNode(): Node(NodeKind::NUM) {}
     };
 
     NodePtr makeNum(int value);
 
+    // structural hashes of nodes built from parts with these hashes
+    std::size_t hash_binop(std::size_t left, Operator op, std::size_t right);
+    std::size_t hash_leaf(NodeKind kind, std::int32_t value);
+
+    /* ==================== TRAVERSAL ==================== */
+
+    // lambdas for different node types as one visitor
+    template <typename... Fs>
+    struct Overloaded : Fs... {
+        using Fs::operator()...;
+    };
+
+    /// @brief Call visitor with node as its own type, like std::visit.
+    /// The switch is inlined into the pass, so there is no indirect call per node
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor, const Node& node) {
+        switch (node.kind) {
+            case NodeKind::BINOP: return visitor(static_cast<const BinOpNode&>(node));
+            case NodeKind::ID: return visitor(static_cast<const IdNode&>(node));
+            default: return visitor(static_cast<const NumNode&>(node));
+        }
+    }
+
+    enum class Side : std::uint8_t { LEFT, RIGHT };
+
+    /// @brief Depth-first walk: enter(node) for every node before its children,
+    /// after(const BinOpNode&, Side) once the child on that side is done (also for null child).
+    /// Uses an explicit stack, so any depth is walked without growing the native stack
+    template <typename Enter, typename After>
+    void walk(const NodePtr& root, Enter&& enter, After&& after) {
+        if (!root) return;
+
+        // binary node with the side to finish next, or node to enter
+        struct Frame {
+            const Node *node;
+            bool entered;
+            Side side;
+        };
+        // frames of usual trees fit into the buffer, deep ones go to the heap
+        std::array<std::byte, 1024> buffer;
+        std::pmr::monotonic_buffer_resource frames(buffer.data(), buffer.size());
+        std::pmr::vector<Frame> stack(&frames);
+        stack.push_back({root.get(), false, Side::LEFT});
+
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            const Node *node = frame.node;
+
+            if (!frame.entered) {
+                enter(*node);
+                if (node->kind != NodeKind::BINOP) {
+                    stack.pop_back();
+                    continue;
+                }
+                frame.entered = true;
+                if (const Node *left = static_cast<const BinOpNode*>(node)->left.get())
+                    stack.push_back({left, false, Side::LEFT});
+                continue;
+            }
+
+            const auto& binop = static_cast<const BinOpNode&>(*node);
+            after(binop, frame.side);
+            if (frame.side == Side::LEFT) {
+                frame.side = Side::RIGHT;
+                if (binop.right) stack.push_back({binop.right.get(), false, Side::LEFT});
+            } else {
+                stack.pop_back();
+            }
+        }
+    }
+
+    /// @brief Bottom-up pass: leaves give fn(const IdNode&) or fn(const NumNode&),
+    /// binary nodes fn(const BinOpNode&, R left, R right) from the results of their children.
+    /// Null nodes give R{}. Nodes are folded left to right, children before parents
+    template <typename R, typename Fn>
+    R fold(const NodePtr& root, Fn&& fn) {
+        std::vector<R> results; // of finished subtrees
+        walk(root,
+            [&](const Node& node) {
+                if (node.kind == NodeKind::ID) results.push_back(fn(static_cast<const IdNode&>(node)));
+                else if (node.kind == NodeKind::NUM) results.push_back(fn(static_cast<const NumNode&>(node)));
+            },
+            [&](const BinOpNode& binop, Side side) {
+                // null children have no results
+                if (side == Side::LEFT) {
+                    if (!binop.left) results.push_back(R{});
+                    return;
+                }
+                if (!binop.right) results.push_back(R{});
+
+                R right = std::move(results.back());
+                results.pop_back();
+                R left = std::move(results.back());
+                results.back() = fn(binop, std::move(left), std::move(right));
+            });
+
+        if (results.empty()) return R{};
+        return std::move(results.back());
+    }
+
+    /// @brief Same structure and values. Different hashes answer at once,
+    /// shared subtrees are not descended into
+    bool equal(const NodePtr& a, const NodePtr& b);
+
     void dumpTreeAsGraphviz(const NodePtr& root, std::ostream& os);
     void dumpTreeAsString(const NodePtr& root, std::ostream& os);
 };
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "AST.hpp"
+
+namespace AST {
+
+    // nodes of a Tree refer to each other by position in it
+    using NodeIndex = std::uint32_t;
+    inline constexpr NodeIndex no_node = std::numeric_limits<NodeIndex>::max();
+
+    // @brief Node of a Tree. Plain record without destructor,
+    // so the whole tree is freed at once with its storage
+    struct TreeNode {
+        std::size_t id; // drawn like Node::id, so dumps of both trees are the same
+        NodeIndex parent = no_node;
+        NodeIndex left = no_node;  // BINOP only
+        NodeIndex right = no_node; // BINOP only
+        std::int32_t value = 0;    // NUM value or ID name_id in symbols()
+        NodeKind kind;
+        Operator op = PLUS;        // BINOP only
+    };
+    static_assert(std::is_trivially_destructible_v<TreeNode>);
+
+    // @brief AST of one parse result with all nodes in one growing block.
+    // Nodes are appended in the order they are built (children before parents)
+    // and live until clear() or destruction of the tree, both O(1)
+    class Tree {
+        std::vector<TreeNode> nodes;
+
+    public:
+        NodeIndex root = no_node;
+
+        NodeIndex add_binop(NodeIndex left, Operator op, NodeIndex right);
+        NodeIndex add_id(std::uint32_t name_id);
+        NodeIndex add_num(int value);
+
+        const TreeNode& operator[](NodeIndex i) const { return nodes[i]; }
+        TreeNode& operator[](NodeIndex i) { return nodes[i]; }
+        std::size_t size() const { return nodes.size(); }
+        bool empty() const { return root == no_node; }
+
+        /// @brief Drop all nodes, keeping the storage for the next tree
+        void clear() {
+            nodes.clear();
+            root = no_node;
+        }
+    };
+
+    /// @brief Depth-first walk of the subtree at root, same order and callbacks as
+    /// AST::walk() with indices: enter(NodeIndex), after(NodeIndex binop, Side).
+    /// Uses an explicit stack
+    template <typename Enter, typename After>
+    void walk(const Tree& tree, NodeIndex root, Enter&& enter, After&& after) {
+        if (root == no_node) return;
+
+        struct Frame {
+            NodeIndex node;
+            bool entered;
+            Side side;
+        };
+        std::array<std::byte, 1024> buffer;
+        std::pmr::monotonic_buffer_resource frames(buffer.data(), buffer.size());
+        std::pmr::vector<Frame> stack(&frames);
+        stack.push_back({root, false, Side::LEFT});
+
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            const TreeNode& node = tree[frame.node];
+
+            if (!frame.entered) {
+                enter(frame.node);
+                if (node.kind != NodeKind::BINOP) {
+                    stack.pop_back();
+                    continue;
+                }
+                frame.entered = true;
+                if (node.left != no_node) stack.push_back({node.left, false, Side::LEFT});
+                continue;
+            }
+
+            after(frame.node, frame.side);
+            if (frame.side == Side::LEFT) {
+                frame.side = Side::RIGHT;
+                if (node.right != no_node) stack.push_back({node.right, false, Side::LEFT});
+            } else {
+                stack.pop_back();
+            }
+        }
+    }
+
+    /// @brief Append copy of the subtree to tree, node ids are kept
+    /// @return index of the copied root, no_node for null node
+    NodeIndex copy_to_tree(const NodePtr& node, Tree& tree);
+
+    /// @brief Subtree at i as separate nodes, node ids are kept
+    NodePtr to_node(const Tree& tree, NodeIndex i);
+
+    // same output as for the NodePtr tree
+    void dumpTreeAsGraphviz(const Tree& tree, std::ostream& os);
+    void dumpTreeAsString(const Tree& tree, std::ostream& os);
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "AST.hpp"
+
+/*
+    Binary AST layout, byte order independent:
+
+        'A' 'S' 'T' 'B'   magic
+        uint8_t           version
+        nodes             preorder, a node is an opcode byte and its operand:
+                              PLUS..DIV    binary node with this Operator,
+                                           followed by its left and right subtrees
+                              NUM          zigzag varint value
+                              ID           varint index into names
+                              NONE         null node, also the whole empty tree
+        varint            n_names
+        names             varint length and bytes of each identifier,
+                          in the order of first use
+
+    Varints are LEB128: 7 bits per byte, low bits first, high bit set on all
+    bytes but the last. Names are stored as text, so a tree read in another
+    process gets its own name ids. Node ids are not stored
+*/
+namespace AST {
+
+    constexpr char binary_magic[4] = {'A', 'S', 'T', 'B'};
+    constexpr std::uint8_t binary_version = 1;
+
+    // binary nodes reuse Operator values as their opcodes
+    enum class BinaryOp : std::uint8_t { PLUS = AST::PLUS, MINUS = AST::MINUS, MUL = AST::MUL, DIV = AST::DIV, NUM, ID, NONE };
+
+    /// @brief Append the tree at root to out in the format above
+    /// @return 0 on success, -1 with out unchanged if a node has an operator outside PLUS..DIV
+    int write_binary(const NodePtr& root, std::vector<std::uint8_t>& out);
+
+    // @brief Node of a serialized tree as the reader passes it to callbacks
+    struct BinaryNode {
+        NodeKind kind;
+        Operator op = PLUS;      // BINOP only
+        std::int32_t value = 0;  // NUM value or ID index into names
+        std::string_view name;   // ID only, points into the serialized bytes
+    };
+
+    // @brief Walks a serialized tree in place, without building nodes or copying bytes.
+    // open() checks the whole image once, so walks decode it without checks.
+    // The bytes must outlive the reader
+    class BinaryReader {
+        std::span<const std::uint8_t> bytes;
+        std::vector<std::string_view> names;
+        std::size_t node_count = 0;
+
+        static std::uint32_t varint(const std::uint8_t *&p) {
+            std::uint32_t value = 0;
+            for (int shift = 0;; shift += 7) {
+                std::uint8_t byte = *p++;
+                value |= std::uint32_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+        }
+
+        BinaryNode node(BinaryOp opcode, const std::uint8_t *&p) const {
+            switch (opcode) {
+                case BinaryOp::NUM: {
+                    std::uint32_t zigzag = varint(p);
+                    return {NodeKind::NUM, PLUS, std::int32_t((zigzag >> 1) ^ -(zigzag & 1)), {}};
+                }
+                case BinaryOp::ID: {
+                    std::uint32_t index = varint(p);
+                    return {NodeKind::ID, PLUS, std::int32_t(index), names[index]};
+                }
+                default:
+                    return {NodeKind::BINOP, Operator(opcode), 0, {}};
+            }
+        }
+
+    public:
+        /// @brief Check the image and read its name table
+        /// @return 0 on success
+        int open(std::span<const std::uint8_t> data);
+
+        /// @brief Nodes in the tree, 0 for the empty tree. Other calls need a successful open()
+        std::size_t size() const { return node_count; }
+        bool empty() const { return node_count == 0; }
+
+        /// @brief Depth-first walk with the order and callbacks of AST::walk():
+        /// enter(const BinaryNode&) before children, after(const BinaryNode& binop, Side)
+        /// once the child on that side is done (also for null child). Uses an explicit stack
+        template <typename Enter, typename After>
+        void walk(Enter&& enter, After&& after) const {
+            struct Frame {
+                BinaryNode binop;
+                Side side;
+            };
+            std::array<std::byte, 1024> buffer;
+            std::pmr::monotonic_buffer_resource frames(buffer.data(), buffer.size());
+            std::pmr::vector<Frame> stack(&frames);
+
+            const std::uint8_t *p = bytes.data() + sizeof(binary_magic) + 1;
+            do {
+                auto opcode = BinaryOp(*p++);
+                if (opcode != BinaryOp::NONE) {
+                    BinaryNode current = node(opcode, p);
+                    enter(current);
+                    if (current.kind == NodeKind::BINOP) {
+                        stack.push_back({current, Side::LEFT});
+                        continue;
+                    }
+                }
+                // subtree is done, so is every binary node whose right subtree it was
+                while (!stack.empty()) {
+                    Frame& frame = stack.back();
+                    after(frame.binop, frame.side);
+                    if (frame.side == Side::LEFT) {
+                        frame.side = Side::RIGHT;
+                        break;
+                    }
+                    stack.pop_back();
+                }
+            } while (!stack.empty());
+        }
+
+        /// @brief The tree as separate nodes, names are interned into symbols()
+        NodePtr to_node() const;
+    };
+
+    // same output as for the NodePtr tree
+    void dumpTreeAsString(const BinaryReader& tree, std::ostream& os);
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AST.hpp"
+
+namespace AST {
+
+    // @brief Node factory with the interface of makeBinOp/makeId/makeNum that returns
+    // the node built before for an identical subtree (hash consing), so repeated
+    // subexpressions are stored once and the result is a DAG. Nodes are kept alive
+    // by the builder until clear(). Equal subtrees from one builder are the same node,
+    // so they compare by pointer. Not thread-safe
+    class DagBuilder {
+        // node fields the table is keyed by; children are already unique, so they compare by address
+        struct Shape {
+            NodeKind kind;
+            std::int32_t value; // Operator, name_id or number
+            const Node *left = nullptr;
+            const Node *right = nullptr;
+            std::size_t hash;
+
+            bool operator==(const Shape&) const = default;
+        };
+        static Shape shape(const Node& node);
+
+        struct ShapeHash {
+            using is_transparent = void;
+            std::size_t operator()(const Shape& shape) const { return shape.hash; }
+            std::size_t operator()(const NodePtr& node) const { return node->hash; }
+        };
+        struct ShapeEqual {
+            using is_transparent = void;
+            bool operator()(const NodePtr& a, const NodePtr& b) const { return a == b; }
+            bool operator()(const Shape& a, const NodePtr& b) const { return a == shape(*b); }
+            bool operator()(const NodePtr& a, const Shape& b) const { return shape(*a) == b; }
+        };
+
+        std::unordered_set<NodePtr, ShapeHash, ShapeEqual> nodes;
+        std::size_t requests = 0;
+
+        template <typename Make>
+        NodePtr find_or_add(const Shape& key, Make&& make);
+
+    public:
+        NodePtr makeBinOp(NodePtr left, Operator op, NodePtr right);
+        NodePtr makeId(std::uint32_t name_id);
+        NodePtr makeId(std::string_view name);
+        NodePtr makeNum(int value);
+
+        /// @brief Distinct nodes built so far
+        std::size_t size() const { return nodes.size(); }
+        /// @brief Nodes asked for, shared ones counted every time
+        std::size_t requested() const { return requests; }
+
+        /// @brief Forget all nodes, those still referenced elsewhere stay valid
+        void clear() {
+            nodes.clear();
+            requests = 0;
+        }
+    };
+
+    // @brief Parents of every node reachable from root, found by one pass that
+    // visits shared subtrees once. In a DAG a node may have several parents,
+    // in a tree every node but the root has one. Valid while the nodes live
+    class ParentMap {
+        std::unordered_map<const Node*, std::vector<const BinOpNode*>> parents;
+
+    public:
+        explicit ParentMap(const NodePtr& root);
+
+        /// @brief Distinct parents of node, empty for the root
+        std::span<const BinOpNode* const> of(const Node& node) const;
+
+        /// @brief Distinct nodes reachable from root
+        std::size_t size() const { return parents.size(); }
+    };
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "AST.hpp"
+
+namespace AST {
+
+    enum class PostfixOp : std::uint8_t { NUM, ID, BINOP };
+
+    // @brief One step of an expression in postfix (reverse Polish) order:
+    // operands come before their operator, the root is the last record
+    struct PostfixItem {
+        PostfixOp opcode;
+        std::int32_t operand; // NUM value, ID name_id in symbols(), BINOP Operator
+    };
+
+    using Postfix = std::vector<PostfixItem>;
+
+    /// @brief Append the subtree to out in postfix order, nothing for null node
+    void to_postfix(const NodePtr& node, Postfix& out);
+
+    /// @brief Tree of one whole expression in postfix order
+    /// @return null if items are empty, don't form exactly one expression,
+    /// have an unknown operator or a name id not in symbols()
+    NodePtr from_postfix(std::span<const PostfixItem> items);
+};
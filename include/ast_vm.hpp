@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "AST.hpp"
+
+namespace AST {
+
+    enum class OpCode : std::uint8_t {
+        PUSH_CONST, PUSH_VAR,       // push operand, or value of variable slot operand
+        ADD, SUB, MUL, DIV,         // pop right, then left, push left op right
+        RSUB, RDIV,                 // same with left popped first: the left operand was pushed last
+        ADD_CONST, SUB_CONST, MUL_CONST, DIV_CONST, // top = top op operand
+        ADD_VAR, SUB_VAR, MUL_VAR, DIV_VAR,         // top = top op value of slot operand
+        RETURN,                     // last instruction, the result is on top
+    };
+
+    // @brief One stack machine step
+    struct Instruction {
+        OpCode op;
+        std::int32_t operand = 0; // constant or variable slot
+    };
+
+    // @brief Expression compiled for repeated evaluation by Evaluator. Every variable
+    // gets a slot, numbered from 0 in the order of first use; values are passed by slot.
+    // Constant subexpressions are computed once at compile time
+    class Program {
+        std::vector<Instruction> code;
+        std::vector<std::uint32_t> slot_names; // name_id in symbols() of each slot
+        std::size_t max_stack = 0;
+
+        friend int compile(const NodePtr& root, Program& program);
+        friend class Evaluator;
+
+    public:
+        static constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+
+        std::span<const Instruction> instructions() const { return code; }
+        /// @brief Values needed on the evaluator stack
+        std::size_t stack_size() const { return max_stack; }
+
+        std::size_t slots() const { return slot_names.size(); }
+        std::string_view slot_name(std::uint32_t slot) const { return symbols().name(slot_names[slot]); }
+        /// @brief Slot of the variable, no_slot if the expression doesn't use it
+        std::uint32_t slot(std::string_view name) const;
+    };
+
+    /// @brief Compile the expression at root into program, replacing its contents
+    /// @return 0 on success, -1 for an empty tree, a tree with null children or an unknown operator
+    int compile(const NodePtr& root, Program& program);
+
+    // @brief Runs compiled programs. Arithmetic is 32-bit and wraps around on overflow
+    // (INT_MIN / -1 gives INT_MIN); division truncates towards zero.
+    // Keeps its stack between runs, so evaluating doesn't allocate. Not thread-safe,
+    // one evaluator per thread can run the same program
+    class Evaluator {
+        std::vector<std::int32_t> stack;
+        std::ostream *error_stream = &std::cerr;
+
+        void report_division(const Program& program, const Instruction& div,
+                             std::int32_t left, std::span<const std::int32_t> values);
+
+    public:
+        enum class Status {
+            SUCCESS,
+            DIV_BY_ZERO,
+            BAD_BINDINGS, // fewer values than the program has slots
+        };
+
+        /// @brief Where evaluation errors are reported, std::cerr by default as for compile().
+        /// nullptr disables the messages
+        void set_error_stream(std::ostream *stream) { error_stream = stream; }
+
+        /// @brief Evaluate program with values[slot] for its variables
+        /// @return SUCCESS with the value in result, or the error
+        Status run(const Program& program, std::span<const std::int32_t> values, std::int32_t& result);
+    };
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "AST.hpp"
+#include "ast_arena.hpp"
+
+namespace AST {
+
+    // @brief Text output of many trees through one reusable buffer. Numbers are
+    // formatted with std::to_chars and fixed parts of the text are precomputed,
+    // so nothing goes through ostream formatting or locales. Trees are written
+    // in the SERIALIZE and GRAPHVIZ forms of dumpTreeAsString()/dumpTreeAsGraphviz(),
+    // byte for byte. With a sink the text is passed on in blocks of about
+    // flush_size bytes, without one the buffer holds everything until clear()
+    class TextWriter {
+        std::vector<char> buffer; // text is buffer[0, used), the rest is spare capacity
+        std::size_t used = 0;
+        std::ostream *sink;
+        std::size_t flush_size;
+
+        // at least n free bytes after the text
+        char *reserve(std::size_t n) {
+            if (buffer.size() - used < n) buffer.resize(std::max(buffer.size() * 2, used + n));
+            return buffer.data() + used;
+        }
+        // pass the text on once there is a whole block
+        void maybe_flush() {
+            if (sink && used >= flush_size) flush();
+        }
+        void put(std::string_view text) {
+            std::memcpy(reserve(text.size()), text.data(), text.size());
+            used += text.size();
+        }
+        void put_number(std::int64_t value) {
+            char *begin = reserve(20);
+            used = std::to_chars(begin, begin + 20, value).ptr - buffer.data();
+        }
+
+        // views of symbols() names, looked up once per writer, so the table isn't locked per node
+        std::vector<std::string_view> names;
+        std::string_view name(std::uint32_t name_id);
+
+        void binop(std::size_t id, Operator op, DumpType type);
+        void leaf(std::size_t id, NodeKind kind, std::int32_t value, DumpType type);
+        void edge(std::size_t from, std::size_t to, Side side);
+        void open_graph();
+        void close_graph();
+
+    public:
+        static constexpr std::size_t default_flush_size = std::size_t(1) << 16;
+
+        explicit TextWriter(std::ostream *sink = nullptr, std::size_t flush_size = default_flush_size)
+            : sink(sink), flush_size(flush_size) {}
+        TextWriter(const TextWriter&) = delete;
+        TextWriter& operator=(const TextWriter&) = delete;
+        // the text not passed on yet is flushed
+        ~TextWriter() { flush(); }
+
+        /// @brief Append the tree as dumpTreeAsString (SERIALIZE) or dumpTreeAsGraphviz (GRAPHVIZ) would
+        void write(const NodePtr& root, DumpType type);
+        void write(const Tree& tree, DumpType type);
+
+        void append(std::string_view text) {
+            put(text);
+            maybe_flush();
+        }
+        void append(char c) {
+            *reserve(1) = c;
+            used++;
+            maybe_flush();
+        }
+        void append_number(std::int64_t value) {
+            put_number(value);
+            maybe_flush();
+        }
+
+        /// @brief Text not passed on yet
+        std::string_view view() const { return {buffer.data(), used}; }
+
+        /// @brief Drop the text, keeping the storage
+        void clear() { used = 0; }
+
+        /// @brief Pass the text to the sink, if there is one
+        void flush();
+    };
+};
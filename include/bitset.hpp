@@ -0,0 +1,75 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SLR {
+
+    // @brief Dense bitset sized at runtime, used for item and symbol sets
+    class Bitset {
+        std::vector<std::uint64_t> words_;
+
+    public:
+        Bitset() = default;
+        explicit Bitset(std::size_t bits): words_((bits + 63) / 64, 0) {}
+
+        void set(std::size_t i) { words_[i / 64] |= std::uint64_t(1) << (i % 64); }
+        void reset(std::size_t i) { words_[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+        bool test(std::size_t i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+
+        void clear() {
+            for (std::uint64_t& w: words_) w = 0;
+        }
+
+        bool any() const {
+            for (std::uint64_t w: words_)
+                if (w) return true;
+            return false;
+        }
+
+        std::size_t count() const {
+            std::size_t n = 0;
+            for (std::uint64_t w: words_) n += std::popcount(w);
+            return n;
+        }
+
+        /// @brief this |= other
+        /// @return true if new bits were added
+        bool merge(const Bitset& other) {
+            std::uint64_t added = 0;
+            for (std::size_t i = 0; i < words_.size(); i++) {
+                added |= other.words_[i] & ~words_[i];
+                words_[i] |= other.words_[i];
+            }
+            return added != 0;
+        }
+
+        /// @brief Call f(index) for every set bit in ascending order
+        template <typename F>
+        void for_each(F f) const {
+            for (std::size_t i = 0; i < words_.size(); i++) {
+                for (std::uint64_t w = words_[i]; w; w &= w - 1) {
+                    f(i * 64 + std::countr_zero(w));
+                }
+            }
+        }
+
+        bool operator==(const Bitset& other) const = default;
+
+        std::size_t hash() const {
+            // FNV-1a over words
+            std::uint64_t h = 0xcbf29ce484222325ull;
+            for (std::uint64_t w: words_) {
+                h ^= w;
+                h *= 0x100000001b3ull;
+            }
+            return h;
+        }
+
+        struct Hash {
+            std::size_t operator()(const Bitset& b) const { return b.hash(); }
+        };
+    };
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "lexer.hpp"
+
+// ---------- LEXER OVER CONTIGUOUS BUFFER ----------
+// Same tokens and positions as mathLexer, but scans characters in place
+// (string, string_view, mapped file) instead of reading through std::istream.
+// Runs of digits, letters and blanks are classified 16 bytes at a time with SSE2
+class DirectLexer {
+    std::string_view text;
+    std::size_t pos = 0;
+    std::size_t line_start = 0; // column is pos - line_start
+    int line = 1;
+    const SymbolMap *symbols = &SymbolMap::none();
+
+    Token current_tok = Token{TokenType::UNKNOWN, "", 0};
+
+public:
+    /// @brief Symbols put into tokens, map must outlive the lexer
+    void set_symbol_map(const SymbolMap& map) {
+        symbols = &map;
+    }
+
+    /// @brief Start scanning text, it must stay alive while tokens are read.
+    /// Offsets are 32-bit, so text must be shorter than 4 GiB
+    void restart(std::string_view input) {
+        text = input;
+        pos = 0;
+        line_start = 0;
+        line = 1;
+    }
+
+    std::string_view source() const {
+        return text;
+    }
+
+    const Token& cur_tok() {
+        return current_tok;
+    }
+
+    const Token& next_tok();
+};
+
+// ---------- LEXER OF INPUT IN CHUNKS ----------
+// Same tokens as DirectLexer for input that arrives in pieces. A token may be split
+// between chunks, so lexemes are copied into the lexer and token offsets refer to them.
+// Offsets are 32-bit: once the lexemes would pass the limit, the input stops with
+// an empty UNKNOWN token marked too_long, as mathLexer does
+class PushLexer {
+    std::string lexemes;
+    std::size_t source_limit = UINT32_MAX;
+    std::string_view chunk;
+    std::size_t pos = 0;
+    bool input_end = false;
+    int line = 1;
+    int col = 0;
+
+    // number or identifier not finished when the chunk ended, END if none
+    TokenType run = TokenType::END;
+    std::uint32_t run_offset = 0;
+    int run_line = 0;
+    int run_col = 0;
+
+    const SymbolMap *symbols = &SymbolMap::none();
+    Token current_tok = Token{TokenType::UNKNOWN, "", 0};
+
+    void end_run();
+    void stop_too_long();
+
+public:
+    /// @brief Symbols put into tokens, map must outlive the lexer
+    void set_symbol_map(const SymbolMap& map) {
+        symbols = &map;
+    }
+
+    /// @brief Bytes of lexemes kept for one input, at most (and by default) UINT32_MAX
+    void set_source_limit(std::uint32_t bytes) {
+        source_limit = bytes;
+    }
+
+    void restart() {
+        lexemes.clear();
+        chunk = {};
+        pos = 0;
+        input_end = false;
+        line = 1;
+        col = 0;
+        run = TokenType::END;
+    }
+
+    /// @brief Continue with the next chunk, it must stay alive until next_tok() returns false
+    void feed(std::string_view bytes) {
+        chunk = bytes;
+        pos = 0;
+    }
+
+    /// @brief No more input, the last token is completed
+    void finish() {
+        chunk = {};
+        pos = 0;
+        input_end = true;
+    }
+
+    std::string_view source() const {
+        return lexemes;
+    }
+
+    const Token& cur_tok() {
+        return current_tok;
+    }
+
+    /// @brief Read the next token into cur_tok()
+    /// @return false if the chunk ended before the token did
+    bool next_tok();
+};
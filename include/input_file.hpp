@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SLR {
+
+    // size of one read() when a file can't be mapped
+    constexpr std::size_t input_block_size = std::size_t(1) << 20;
+
+    // @brief Read-only contents of an input file. Regular files are mapped with
+    // sequential read-ahead, anything else (pipes, devices, empty files) is read in large blocks
+    class InputFile {
+        const char *data_ = nullptr;
+        std::size_t size_ = 0;
+        bool mapped_ = false;
+        std::size_t released = 0; // pages before it were released
+        std::string buffer; // contents of a file that isn't mapped
+
+        friend class LineBlockReader;
+        /// @brief Map fd if it is a non-empty regular file
+        bool map(int fd);
+
+    public:
+        InputFile() = default;
+        InputFile(const InputFile&) = delete;
+        InputFile& operator=(const InputFile&) = delete;
+        ~InputFile();
+
+        /// @brief Map or read the whole file
+        /// @return 0 on success, -1 if file can't be opened or read
+        int open(const std::string& path);
+
+        std::string_view view() const {
+            return {data_, size_};
+        }
+
+        bool is_mapped() const {
+            return mapped_;
+        }
+
+        /// @brief Let the system drop mapped pages before offset, they are read
+        /// from the file again if accessed. Does nothing for files that aren't mapped
+        void release(std::size_t offset);
+    };
+
+    // @brief File as a sequence of blocks of whole lines, at most window bytes each.
+    // Regular files are mapped and pages of passed blocks are released,
+    // other files are read into one window-sized buffer
+    class LineBlockReader {
+    public:
+        enum class Status {LINES, TOO_LONG, END, READ_ERR};
+
+        LineBlockReader() = default;
+        LineBlockReader(const LineBlockReader&) = delete;
+        LineBlockReader& operator=(const LineBlockReader&) = delete;
+        ~LineBlockReader();
+
+        /// @return 0 on success, -1 if file can't be opened
+        int open(const std::string& path, std::size_t window);
+
+        /// @brief Next block of lines, it ends with '\n' or at the end of file and
+        /// is valid until the next call.
+        /// TOO_LONG: line didn't fit into the window, it is skipped up to its '\n'
+        Status next(std::string_view& block);
+
+    private:
+        int fd = -1;
+        std::size_t window = 0;
+
+        // mapped file
+        InputFile file;
+        std::size_t pos = 0;
+
+        // buffered file: unread data is buffer[begin, end)
+        std::vector<char> buffer;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        bool eof = false;
+
+        /// @brief Unread data, up to window bytes. False on read error
+        bool fill(std::string_view& avail);
+        void consume(std::size_t n);
+    };
+};
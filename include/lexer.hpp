@@ -1,8 +1,17 @@
 #pragma once
 
+#include <charconv>
+#include <concepts>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <streambuf>
 #include <string>
-#include <cstdlib>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 
 # ifndef __FLEX_LEXER_H
 #  define yyFlexLexer mathFlexLexer
@@ -11,66 +20,159 @@
 # endif
 
 // ---------- Token struct ----------
-enum class TokenType { END = 0, NUMBER, OPERATOR, IDENTIFIER, UNKNOWN };
+enum class TokenType : std::uint8_t { END = 0, NUMBER, OPERATOR, IDENTIFIER, UNKNOWN };
 
+// ---------- GRAMMAR SYMBOLS OF TOKENS ----------
+// lets keywords be looked up by std::string_view
+struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+// @brief Parser symbol codes lexers put into tokens, built from the terminals of a grammar.
+// Codes of terminals the grammar doesn't use stay 0 (EPS), which has no actions,
+// so such tokens are syntax errors
+struct SymbolMap {
+    static constexpr std::int32_t error_symbol = -1; // not a table column, the parser stops on it
+
+    std::int32_t number = 0;
+    std::int32_t identifier = 0;
+    std::int32_t end = 0;
+    // quoted terminals: one-char ones by char, longer ones are keywords.
+    // Lexers give OPERATOR tokens for every char with a code here, not only for -+*/()
+    std::array<std::int32_t, 256> operators{};
+    std::unordered_map<std::string, std::int32_t, StringHash, std::equal_to<>> keywords;
+
+    /// @brief Symbol of an identifier lexeme: its keyword or identifier
+    std::int32_t word(std::string_view lexeme) const {
+        if (!keywords.empty()) {
+            auto it = keywords.find(lexeme);
+            if (it != keywords.end()) return it->second;
+        }
+        return identifier;
+    }
+
+    /// @brief Map of lexers not attached to a parser, every code is 0
+    static const SymbolMap& none() {
+        static const SymbolMap map;
+        return map;
+    }
+};
+
+// Lexeme is not stored: token refers to the source text of its lexer by offset and length,
+// so tokens are copied around the parse stacks without allocations
 struct Token {
     TokenType type_;
-    std::string lexeme_;
+    char op_char = 0;
+    bool out_of_range = false; // number doesn't fit into int, token is UNKNOWN then
+    bool too_long = false; // source of the lexer would pass 4 GiB, token is UNKNOWN and empty then
+    std::int32_t symbol_ = 0; // parser symbol set by the lexer from its SymbolMap
+    std::uint32_t offset_;
+    std::uint32_t length_;
     int line_;
     int pos_;
-    int int_val;
-    char op_char;
+    int int_val = 0;
 
-    Token(TokenType T, const char *text, int line = 0, int pos = 0) :type_(T), lexeme_(text), line_(line), pos_(pos) {
+    Token(TokenType T, std::string_view text, std::uint32_t offset, int line = 0, int pos = 0)
+        :type_(T), offset_(offset), length_(text.size()), line_(line), pos_(pos) {
         switch(T) {
-        case TokenType::END:
-            int_val = 0;
-            break;
-        case TokenType::NUMBER:
-            int_val = std::atoi(text);
+        case TokenType::NUMBER: {
+            auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), int_val);
+            if (ec == std::errc::result_out_of_range) {
+                type_ = TokenType::UNKNOWN;
+                out_of_range = true;
+            }
             break;
+        }
         case TokenType::OPERATOR:
             op_char = text[0];
             break;
-        case TokenType::IDENTIFIER:
-            break;
-        case TokenType::UNKNOWN:
-            break;
         default:
             break;
         }
     }
+
+    std::string_view lexeme(std::string_view source) const {
+        return source.substr(offset_, length_);
+    }
+};
+static_assert(std::is_trivially_copyable_v<Token>);
+
+// ---------- LEXER INTERFACE ----------
+// What the parse loop needs from a lexer: next_tok() advances, cur_tok() is the last token.
+// After the end of input next_tok() keeps returning END.
+// source() is the text token offsets refer to, it may move when the next token is read
+template <typename L>
+concept TokenSource = requires(L lexer) {
+    { lexer.next_tok() } -> std::convertible_to<const Token&>;
+    { lexer.cur_tok() } -> std::convertible_to<const Token&>;
+    { lexer.source() } -> std::convertible_to<std::string_view>;
 };
 
-inline std::ostream& operator<<(std::ostream& os, const Token& tok) {
-    switch(tok.type_) {
-        case TokenType::END: os << "$"; break;
-        case TokenType::NUMBER: os << tok.int_val; break;
-        case TokenType::OPERATOR: os << tok.op_char; break;
-        case TokenType::IDENTIFIER: os << tok.lexeme_; break;
-        case TokenType::UNKNOWN: os << "UNK:" << tok.lexeme_; break;
-        default: break;
+// ---------- INPUT OVER STRING VIEW ----------
+// Read-only stream buffer over existing characters, reset() doesn't copy or allocate
+class ViewStreamBuf : public std::streambuf {
+public:
+    void reset(std::string_view text) {
+        char *begin = const_cast<char*>(text.data()); // get area is never written
+        setg(begin, begin, begin + text.size());
     }
-    return os;
-}
+};
 
 // ---------- LEXER CLASS  ----------
 class mathLexer : public mathFlexLexer {
 private:
-    Token current_tok = Token{TokenType::UNKNOWN, ""};
+    Token current_tok = Token{TokenType::UNKNOWN, "", 0};
     int yycol = 0;
+    const SymbolMap *symbols = &SymbolMap::none();
+    // flex reuses its buffer, so lexemes of the current input are kept here
+    std::string lexemes;
 
     template<TokenType T>
     void add_token(const char *text) {
         // tokens.push_back({T, text});
-        current_tok = Token{T, text, lineno(), yycol};
+        if (lexemes.size() + yyleng > UINT32_MAX) {
+            // offsets are 32-bit, so the parse stops here as parse_view() does for such input
+            current_tok = Token{TokenType::UNKNOWN, "", std::uint32_t(lexemes.size()), lineno(), yycol};
+            current_tok.too_long = true;
+            current_tok.symbol_ = SymbolMap::error_symbol;
+            return;
+        }
+        std::string_view lexeme(text, yyleng);
+        current_tok = Token{T, lexeme, std::uint32_t(lexemes.size()), lineno(), yycol};
+        if constexpr (T == TokenType::NUMBER) {
+            current_tok.symbol_ = current_tok.out_of_range ? SymbolMap::error_symbol : symbols->number;
+        } else if constexpr (T == TokenType::OPERATOR) {
+            current_tok.symbol_ = symbols->operators[static_cast<unsigned char>(text[0])];
+        } else if constexpr (T == TokenType::IDENTIFIER) {
+            current_tok.symbol_ = symbols->word(lexeme);
+        } else if (std::int32_t symbol = symbols->operators[static_cast<unsigned char>(text[0])]) {
+            // the rules know only the built-in operators, others are terminals of the grammar
+            current_tok = Token{TokenType::OPERATOR, lexeme, std::uint32_t(lexemes.size()), lineno(), yycol};
+            current_tok.symbol_ = symbol;
+        } else {
+            current_tok.symbol_ = SymbolMap::error_symbol;
+        }
+        lexemes += lexeme;
     }
 
     int yylex() override;
 public:
+    /// @brief Symbols put into tokens, map must outlive the lexer
+    void set_symbol_map(const SymbolMap& map) {
+        symbols = &map;
+    }
+
+    // flex keeps its buffer across restarts
     void restart(std::istream& in) {
         yyrestart(in);
+        yylineno = 1;
         yycol = 0;
+        lexemes.clear();
+    }
+
+    std::string_view source() const {
+        return lexemes;
     }
 
     const Token& cur_tok() {
@@ -80,7 +182,8 @@ public:
     const Token& next_tok() {
         if (yylex()) {
         } else {
-            current_tok = {TokenType::END, "", lineno(), yycol};
+            current_tok = {TokenType::END, "", std::uint32_t(lexemes.size()), lineno(), yycol};
+            current_tok.symbol_ = symbols->end;
         }
         return current_tok;
     }
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "syntax_analyzer.hpp"
+
+// @brief Results of parse_lines, one entry per input line in input order
+struct LineResults {
+    std::vector<Parser::ParseStatus> status;
+    std::vector<std::string> serialized; // AST in SERIALIZE form, "<EMPTY_TREE>" on errors
+
+    std::size_t size() const { return status.size(); }
+};
+
+/// @brief Split text into lines ('\n', optional '\r' before it) and parse every line
+/// as a separate expression. Chunks of lines are parsed on n_threads workers
+/// (hardware concurrency if 0) with work stealing, each worker has its own Parser
+/// over the shared tables. Error messages are not printed
+LineResults parse_lines(const ParseTables& tables, std::string_view text, unsigned n_threads = 0);
+
+/// @brief Same results as parse_lines on two threads pipelined instead of split by lines:
+/// one tokenizes blocks of lines into TokenBuffer objects, the other parses
+/// the previous block while the next one is tokenized
+LineResults parse_lines_pipelined(const ParseTables& tables, std::string_view text);
+
+/// @brief Same as above for a whole file, the file is mapped instead of copied
+/// @return 0 on success, -1 if file can't be read
+int parse_file_lines(const ParseTables& tables, const std::string& path, LineResults& results,
+                     unsigned n_threads = 0);
+
+// @brief Called for every line of stream_file_lines in input order, line numbers start at 1
+using LineCallback = std::function<void(std::size_t line, Parser::ParseStatus status,
+                                        const std::string& serialized)>;
+
+constexpr std::size_t default_line_window = std::size_t(64) << 20;
+
+/// @brief Parse a file line by line as parse_file_lines does, but holding at most
+/// window bytes of it (and results of those lines) in memory at once.
+/// Lines longer than the window are skipped and reported as BAD_INPUT
+/// @return 0 on success, -1 if file can't be read
+int stream_file_lines(const ParseTables& tables, const std::string& path, const LineCallback& on_line,
+                      std::size_t window = default_line_window, unsigned n_threads = 0);
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace SLR {
+
+    enum ActionType : std::uint16_t { ERROR=0, GOTO, SHIFT, REDUCE, ACCEPT };
+
+    // @brief Table cell packed into 32 bits
+    // val is a state (SHIFT, GOTO) or production id (REDUCE)
+    struct ActionEntry {
+        ActionType type;
+        std::int16_t val;
+
+        constexpr ActionEntry(): type(ERROR), val(-1) {} // ERROR must be default
+        constexpr ActionEntry(ActionType t, int v): type(t), val(v) {}
+
+        constexpr bool operator==(const ActionEntry& other) const {
+            return type == other.type && val == other.val;
+        }
+    };
+    static_assert(sizeof(ActionEntry) == 4);
+
+    // @brief Production data needed by the parse loop on reduce
+    struct ReduceInfo {
+        std::uint16_t lhs;
+        std::uint16_t rhs_len;
+    };
+    static_assert(sizeof(ReduceInfo) == 4);
+
+    /* ============= COMPILE-TIME TABLE CONSTRUCTION ============== */
+
+    // @brief Grammar in flat form, usable in constant expressions
+    // Symbol 0 is EPS, production 0 is the augmented start rule
+    template <std::size_t NSym, std::size_t NProd, std::size_t MaxRhs>
+    struct GrammarSpec {
+        std::array<bool, NSym> is_term{};
+        std::array<int, NProd> lhs{};
+        std::array<std::array<int, MaxRhs>, NProd> rhs{};
+        std::array<int, NProd> rhs_len{};
+        int end_sym = 0;
+    };
+
+    template <std::size_t NSym, std::size_t MaxStates>
+    struct RawTables {
+        std::array<ActionEntry, MaxStates * NSym> cells{};
+        std::size_t n_states = 0;
+        int conflicts = 0;
+        bool overflow = false; // MaxStates was too small
+    };
+
+    /// @brief Same construction as ParseTables::init() on fixed-size arrays
+    /// States are numbered in the same order, so the result matches runtime tables
+    template <std::size_t MaxStates, std::size_t NSym, std::size_t NProd, std::size_t MaxRhs>
+    constexpr RawTables<NSym, MaxStates> build_tables(const GrammarSpec<NSym, NProd, MaxRhs>& g) {
+        // item (prod, dot) is stored as prod * W + dot
+        constexpr std::size_t W = MaxRhs + 1;
+        constexpr std::size_t NItems = NProd * W;
+        using ItemSet = std::array<bool, NItems>;
+
+        RawTables<NSym, MaxStates> res{};
+
+        auto item_symbol = [&](std::size_t item) {
+            std::size_t prod = item / W, dot = item % W;
+            return int(dot) < g.rhs_len[prod] ? g.rhs[prod][dot] : g.end_sym;
+        };
+
+        auto closure = [&](ItemSet& set) {
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                for (std::size_t item = 0; item < NItems; item++) {
+                    if (!set[item]) continue;
+                    int s = item_symbol(item);
+                    if (g.is_term[s]) continue;
+
+                    for (std::size_t p = 0; p < NProd; p++) {
+                        if (g.lhs[p] == s && !set[p * W]) {
+                            set[p * W] = true;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        };
+
+        /* ---------- canonic states ---------- */
+        std::array<ItemSet, MaxStates> states{};
+        std::array<std::array<int, NSym>, MaxStates> transitions{};
+        for (auto& row: transitions) row.fill(-1);
+
+        states[0][0] = true;
+        closure(states[0]);
+        std::size_t n_states = 1;
+
+        for (std::size_t i = 0; i < n_states; i++) {
+            // ascending symbol order, like iterating std::set<Symbol>
+            for (std::size_t s = 0; s < NSym; s++) {
+                if (int(s) == g.end_sym) continue;
+
+                ItemSet next{};
+                bool empty = true;
+                for (std::size_t item = 0; item < NItems; item++) {
+                    if (states[i][item] && item_symbol(item) == int(s) &&
+                        int(item % W) < g.rhs_len[item / W]) {
+                        next[item + 1] = true;
+                        empty = false;
+                    }
+                }
+                if (empty) continue;
+                closure(next);
+
+                std::size_t j = 0;
+                while (j < n_states && states[j] != next) j++;
+                if (j == n_states) {
+                    if (n_states == MaxStates) {
+                        res.overflow = true;
+                        return res;
+                    }
+                    states[n_states++] = next;
+                }
+                transitions[i][s] = int(j);
+            }
+        }
+        res.n_states = n_states;
+
+        /* ---------- FIRST ---------- */
+        std::array<std::array<bool, NSym>, NSym> first{};
+        std::array<bool, NSym> nullable{};
+        for (std::size_t s = 0; s < NSym; s++)
+            if (g.is_term[s]) first[s][s] = true;
+
+        auto merge = [](std::array<bool, NSym>& dest, const std::array<bool, NSym>& src) {
+            bool changed = false;
+            for (std::size_t t = 0; t < NSym; t++) {
+                if (src[t] && !dest[t]) {
+                    dest[t] = true;
+                    changed = true;
+                }
+            }
+            return changed;
+        };
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (std::size_t p = 0; p < NProd; p++) {
+                bool all_nullable = true;
+                for (int k = 0; k < g.rhs_len[p]; k++) {
+                    int X = g.rhs[p][k];
+                    changed |= merge(first[g.lhs[p]], first[X]);
+                    if (!nullable[X]) {
+                        all_nullable = false;
+                        break;
+                    }
+                }
+                if (all_nullable && !nullable[g.lhs[p]]) {
+                    nullable[g.lhs[p]] = true;
+                    changed = true;
+                }
+            }
+        }
+
+        /* ---------- FOLLOW ---------- */
+        std::array<std::array<bool, NSym>, NSym> follow{};
+        follow[g.lhs[0]][g.end_sym] = true;
+
+        changed = true;
+        while (changed) {
+            changed = false;
+            for (std::size_t p = 0; p < NProd; p++) {
+                for (int k = 0; k < g.rhs_len[p]; k++) {
+                    int X = g.rhs[p][k];
+                    if (g.is_term[X]) continue;
+
+                    bool rest_nullable = true;
+                    for (int m = k + 1; m < g.rhs_len[p] && rest_nullable; m++) {
+                        changed |= merge(follow[X], first[g.rhs[p][m]]);
+                        rest_nullable = nullable[g.rhs[p][m]];
+                    }
+                    if (rest_nullable)
+                        changed |= merge(follow[X], follow[g.lhs[p]]);
+                }
+            }
+        }
+
+        /* ---------- ACTION/GOTO ---------- */
+        auto cell = [&](std::size_t state, int s) -> ActionEntry& {
+            return res.cells[state * NSym + s];
+        };
+
+        for (std::size_t i = 0; i < n_states; i++) {
+            for (std::size_t item = 0; item < NItems; item++) {
+                if (!states[i][item]) continue;
+                std::size_t prod = item / W;
+                int s = item_symbol(item);
+
+                if (int(item % W) == g.rhs_len[prod]) {
+                    if (prod == 0) {
+                        cell(i, g.end_sym) = {ACCEPT, 0};
+                        continue;
+                    }
+                    for (std::size_t t = 0; t < NSym; t++) {
+                        if (!follow[g.lhs[prod]][t]) continue;
+                        if (cell(i, t).type != ERROR) res.conflicts++;
+                        else cell(i, t) = {REDUCE, int(prod)};
+                    }
+                } else {
+                    int j = transitions[i][s];
+                    ActionEntry& entry = cell(i, s);
+                    if (entry.type != ERROR && !(entry.type == SHIFT && entry.val == j))
+                        res.conflicts++;
+                    else
+                        entry = {SHIFT, j};
+                }
+            }
+
+            for (std::size_t s = 0; s < NSym; s++) {
+                if (transitions[i][s] >= 0 && !g.is_term[s])
+                    cell(i, s) = {GOTO, transitions[i][s]};
+            }
+        }
+
+        return res;
+    }
+
+    /// @brief Cut RawTables down to the states that were actually built
+    template <std::size_t NStates, std::size_t NSym, std::size_t MaxStates>
+    constexpr std::array<ActionEntry, NStates * NSym> trim_tables(const RawTables<NSym, MaxStates>& raw) {
+        static_assert(NStates <= MaxStates);
+        std::array<ActionEntry, NStates * NSym> cells{};
+        for (std::size_t i = 0; i < cells.size(); i++)
+            cells[i] = raw.cells[i];
+        return cells;
+    }
+};
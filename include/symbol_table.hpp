@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace AST {
+
+    // lets the maps below be searched by std::string_view
+    struct NameHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    // @brief Interned identifier names. Ids are dense from 0 in order of first intern(),
+    // names are never removed. Safe to use from any number of threads
+    class SymbolTable {
+        mutable std::shared_mutex mutex;
+        std::deque<std::string> names; // elements don't move, so views of them stay valid
+        std::unordered_map<std::string_view, std::uint32_t, NameHash, std::equal_to<>> ids;
+
+    public:
+        SymbolTable() = default;
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+        /// @brief Id of name, added to the table if it is new
+        std::uint32_t intern(std::string_view name);
+
+        /// @brief Name of an interned id, valid while the table exists
+        std::string_view name(std::uint32_t id) const;
+
+        std::size_t size() const;
+    };
+
+    /// @brief Table of IdNode names, shared by all parsers
+    SymbolTable& symbols();
+
+    // @brief Names already looked up in a SymbolTable by one thread, so repeated
+    // names are found without locking the table. Not thread-safe itself
+    class SymbolCache {
+        SymbolTable& table;
+        std::unordered_map<std::string_view, std::uint32_t, NameHash, std::equal_to<>> ids; // keys are views into table
+
+    public:
+        explicit SymbolCache(SymbolTable& table): table(table) {}
+
+        std::uint32_t intern(std::string_view name) {
+            auto it = ids.find(name);
+            if (it != ids.end()) return it->second;
+
+            std::uint32_t id = table.intern(name);
+            ids.emplace(table.name(id), id);
+            return id;
+        }
+    };
+};
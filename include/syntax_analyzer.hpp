@@ -1,36 +1,72 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <cstdint>
 #include <memory>
-#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "AST.hpp"
+#include "ast_arena.hpp"
+#include "ast_dag.hpp"
+#include "ast_postfix.hpp"
+#include "bitset.hpp"
+#include "direct_lexer.hpp"
+#include "input_file.hpp"
 #include "lexer.hpp"
+#include "slr_table.hpp"
+#include "table_file.hpp"
+#include "table_layout.hpp"
+#include "token_buffer.hpp"
+
+
+// nodes are AST::NodeIndex into ReduceContext::tree or ReduceContext::postfix
+// when one of them is set, AST::NodePtr otherwise
+using ValueStack = std::vector<std::variant<Token, AST::NodePtr, AST::NodeIndex>>;
+
+// @brief What reducers may read besides the value stack
+struct ReduceContext {
+    std::string_view source; // text token offsets refer to, see Token::lexeme()
+    AST::SymbolCache& symbols; // interns identifier names into AST::symbols()
+    AST::Tree *tree = nullptr; // arena of the result, see Parser::AstStorage
+    AST::Postfix *postfix = nullptr; // postfix records of the result, node index is its last record
+    AST::DagBuilder *dag = nullptr; // builds NodePtr values when set, instead of AST::make*()
+};
 
-
-using reduceFunc = void(std::vector<std::variant<Token, AST::NodePtr>>& ast);
+using reduceFunc = void(ValueStack& ast, const ReduceContext& ctx);
 reduceFunc reduceBinOp;
 reduceFunc reduceParen;
 reduceFunc reduceNumId;
 
-class SyntaxAnalyzer {
+class Parser;
+
+// @brief Grammar and action/goto tables. Read-only once initialized,
+// so any number of Parser objects may share one instance across threads
+class ParseTables {
+    friend class Parser;
+
 public:
     /* ============= SYMBOLS AND PRODUCTION ====================== */
-    enum Symbol {
+
+    // Symbols are dense ids of the current grammar, EPS is always 0.
+    // Named values are ids of the built-in grammar
+    enum Symbol : int {
         EPS, // special symbol
         E0, E, T, F,
-        NUM, ID, PLUS, MINUS, MUL, DIV, LBRACKET, RBRACKET, END
+        NUM, ID, PLUS, MINUS, MUL, DIV, LBRACKET, RBRACKET, END,
+        LEX_ERROR = SymbolMap::error_symbol // symbol of tokens the lexer rejected, has no table column
     };
-    Symbol token_to_symbol(const Token& tok);
 
-    const std::vector<Symbol> allSymbols = {
-        E0, E, T, F,
-        NUM, ID, PLUS, MINUS, MUL, DIV, LBRACKET, RBRACKET, END
-    };
+    /// @brief Append tokens of expr and its END to out, expr must lie inside out.source
+    void tokenize(std::string_view expr, TokenBuffer& out) const;
 
-    inline bool isTerm(Symbol s) {
+    /// @brief Terminals of the built-in grammar
+    static constexpr bool isBuiltinTerm(Symbol s) {
         switch(s) {
             case E0: case E: case T: case F:
                 return false;
@@ -38,7 +74,6 @@ public:
             case LBRACKET: case RBRACKET: case END:
                 return true;
             default:
-                std::cerr << s << " is not a valid symbol\n";
                 return false;
         }
     }
@@ -48,7 +83,46 @@ public:
         Symbol lhs;
         std::vector<Symbol> rhs;
 
-        reduceFunc *reduce;
+        std::string action; // name of semantic action, empty if none
+    };
+
+    // @brief Symbols and productions of the parsed language
+    struct Grammar {
+        std::vector<std::string> names;     // indexed by Symbol
+        std::vector<std::uint8_t> is_term;  // indexed by Symbol
+        std::vector<Production> productions;
+
+        // production 0 is start_symbol -> smth
+        Symbol start_symbol = EPS;
+        Symbol end_symbol = EPS;
+
+        // terminals of tokens, lexers put them into Token::symbol_
+        SymbolMap tokens;
+
+        std::size_t size() const { return productions.size(); }
+        const Production& operator[](std::size_t i) const { return productions[i]; }
+        auto begin() const { return productions.begin(); }
+        auto end() const { return productions.end(); }
+
+        int symbols_count() const { return names.size(); }
+
+        /// @brief Grammar described by builtin_grammar
+        static Grammar builtin();
+
+        /// @brief Read grammar in BNF form:
+        ///     # comment
+        ///     E -> E '+' T @binop | T ;
+        ///     F -> '(' E ')' @paren | id @numid | num @numid ;
+        /// Lhs of the first rule is the start symbol, grammar is augmented
+        /// automatically. Quoted terminals are matched against token text,
+        /// bare terminals 'num' and 'id' match NUMBER and IDENTIFIER tokens,
+        /// '@name' binds semantic action, '%empty' is an empty alternative
+        /// @return 0 on success, -1 on error (reported to std::cerr)
+        int load(std::istream& in);
+
+    private:
+        Symbol add_symbol(const std::string& name);
+        std::unordered_map<std::string, Symbol> symbol_ids;
     };
 
     /* ================= LANGUAGE GRAMMAR RULES ================ */
@@ -60,23 +134,72 @@ public:
         F -> ( E ) | id | num
     */
 
-    const static inline Symbol start_symbol = E0;
-    const static inline std::vector<Production> grammar = {
+    // @brief Production with fixed-size rhs, padded with EPS
+    struct ProductionSpec {
+        Symbol lhs;
+        std::array<Symbol, 3> rhs;
+
+        std::string_view action; // empty when omitted
+
+        constexpr int rhs_len() const {
+            int len = 0;
+            while (len < int(rhs.size()) && rhs[len] != EPS) len++;
+            return len;
+        }
+    };
+
+    static constexpr ProductionSpec builtin_grammar[] = {
         {E0, {E}},
 
         {E, {T}},
-        {E, {E, PLUS, T}, reduceBinOp},
-        {E, {E, MINUS, T}, reduceBinOp},
+        {E, {E, PLUS, T}, "binop"},
+        {E, {E, MINUS, T}, "binop"},
 
         {T, {F}},
-        {T, {T, MUL, F}, reduceBinOp},
-        {T, {T, DIV, F}, reduceBinOp},
+        {T, {T, MUL, F}, "binop"},
+        {T, {T, DIV, F}, "binop"},
+
+        {F, {LBRACKET, E, RBRACKET}, "paren"},
+        {F, {ID}, "numid"},
+        {F, {NUM}, "numid"}
+    };
+
+    // @brief Semantic action available to grammars under this name
+    struct NamedAction {
+        std::string_view name;
+        reduceFunc *reduce;
+    };
 
-        {F, {LBRACKET, E, RBRACKET}, reduceParen},
-        {F, {ID}, reduceNumId},
-        {F, {NUM}, reduceNumId}
+    static constexpr NamedAction builtin_actions[] = {
+        {"binop", reduceBinOp},
+        {"paren", reduceParen},
+        {"numid", reduceNumId}
     };
 
+private:
+    Grammar grammar = Grammar::builtin();
+    bool grammar_is_builtin = true;
+    // all symbols except EPS
+    std::vector<Symbol> allSymbols;
+    int numSymbols = 0;
+
+    std::unordered_map<std::string, reduceFunc*> actions;
+
+    /// @brief Recompute symbol lists after grammar change
+    void use_grammar();
+    /// @brief Resolve production actions to reducers
+    /// @return 0 on success, -1 if some action is not bound
+    int bind_reducers();
+
+public:
+    inline bool isTerm(Symbol s) const {
+        return grammar.is_term[s];
+    }
+
+    const std::string& symbol_name(Symbol s) const {
+        return grammar.names[s];
+    }
+
     /* ================= ITEM ======================== */
 
     // @brief Production from grammar + dot position
@@ -90,77 +213,228 @@ public:
         bool operator==(const Item& other) const {
             return id == other.id && dotPos == other.dotPos;
         }
-        std::ostream& print_item(std::ostream& os);
     };
 
-    inline Symbol get_item_symbol(Item item) {
+    std::ostream& print_item(std::ostream& os, Item item) const;
+
+    inline Symbol get_item_symbol(Item item) const {
         const std::vector<Symbol>& rhs = grammar[item.id].rhs;
-        if (item.dotPos == rhs.size()) return END;
+        if (item.dotPos == rhs.size()) return grammar.end_symbol;
 
         return rhs[item.dotPos];
     }
 
+    /* ================= TABLE TYPES ================ */
+
+    using ActionType = SLR::ActionType;
+    using enum SLR::ActionType;
+    using ActionEntry = SLR::ActionEntry;
+
+    using ReduceInfo = SLR::ReduceInfo;
+
+    static constexpr int builtinSymbols = END + 1;
+
     /* ================ HELPERS =================== */
 
-    using State_t = std::set<Item>;
+    // bit i stands for items[i]
+    using State_t = SLR::Bitset;
+    // bit per Symbol, EPS bit marks nullable string
+    using SymbolSet = SLR::Bitset;
 
 private:
-    State_t state_closure(State_t I);
+    // dense item numbering: item {prod, dot} has index item_offset[prod] + dot
+    std::vector<Item> items;
+    std::vector<int> item_offset;
+    // closure of all items {A -> · smth} for every nonterminal A
+    std::vector<State_t> nonterm_closure;
 
-    State_t state_goto(State_t I, Symbol s);
+    void index_items();
 
+    State_t state_closure(const State_t& kernel);
 
-    std::set<Symbol> first_of_string(const std::vector<Symbol>& rhs);
+    SymbolSet first_of_string(std::span<const Symbol> rhs);
 
     std::vector<State_t> build_canonic_states();
     int compute_first();
     int compute_follow();
-    int build_action_goto();
+    int compute_lalr_lookaheads();
+
+public:
+    // @brief How reductions get their lookahead symbols
+    // SLR puts reduction by A -> w on whole FOLLOW(A), LALR computes
+    // lookaheads per state over the same LR(0) automaton (DeRemer & Pennello)
+    enum class Lookahead { SLR, LALR };
+
+private:
+    int build_action_goto(Lookahead lookahead);
 
     /* ================ ACTION TABLE ============================ */
-    std::map<Symbol, std::set<Symbol>> FIRST;
-    std::map<Symbol, std::set<Symbol>> FOLLOW;
+    std::vector<SymbolSet> FIRST;
+    std::vector<SymbolSet> FOLLOW;
 
     std::vector<State_t> states; // canonic states
 
-    enum ActionType { ERROR=0, GOTO, SHIFT, REDUCE, ACCEPT };
+    // LALR(1) lookaheads: {production, lookahead set} for every completed item
+    // of a state, empty unless tables were built with Lookahead::LALR
+    std::vector<std::vector<std::pair<int, SymbolSet>>> lookaheads;
 
-    struct ActionEntry {
-        ActionType type;
-        int val;
+    // index of transition on s in state_transitions[state], -1 if there is none
+    int transition_index(int state, Symbol s) const;
+    const SymbolSet& reduce_lookahead(int state, int prod, Lookahead lookahead) const;
 
-        ActionEntry(): type(ERROR), val(-1) {} // ERROR must be default
-        ActionEntry(ActionType t, int v): type(t), val(v) {}
+    std::ostream& print_action(std::ostream& os, const ActionEntry& entry) const;
 
-        bool operator==(const ActionEntry& other) {
-            return type == other.type && val == other.val;
-        }
+    // unified action and goto table, filled by build_action_goto()
+    // row-major: cell for (state, symbol) is at state * numSymbols + symbol
+    // outgoing transitions {symbol, target} of every state, ascending by symbol
+    std::vector<std::vector<std::pair<Symbol, int>>> state_transitions;
+    std::vector<ActionEntry> action_goto;
+    // indexed by production id, parallel to grammar
+    std::vector<ReduceInfo> reduce_info;
+    // reducers bound by action name, indexed by production id
+    std::vector<reduceFunc*> reducers;
+
+    inline ActionEntry& cell(int state, Symbol s) {
+        return action_goto[state * numSymbols + s];
+    }
+
+    // tables read by the parse loop: either the vectors above,
+    // the tables generated at compile time or a mapped table file
+    const ActionEntry *action_table = nullptr;
+    const ReduceInfo *reduce_table = nullptr;
+    reduceFunc * const *reducer_table = nullptr;
+    int states_count = 0;
+
+    std::unique_ptr<SLR::MappedTableFile> table_file;
+
+public:
+    // @brief Size of the automaton and conflicts found by the last init()
+    struct TableStats {
+        int states = 0;
+        int nonterm_transitions = 0; // LALR only
+        int shift_reduce = 0;
+        int reduce_reduce = 0;
+
+        std::size_t dense_bytes = 0;
+        std::size_t compressed_bytes = 0; // 0 unless set_table_layout(COMPRESSED) was called
+
+        int conflicts() const { return shift_reduce + reduce_reduce; }
     };
 
-    std::ostream& print_action(std::ostream& os, const ActionEntry& entry);
+private:
+    TableStats stats;
 
-    // unified action and goto table
-    std::map<std::pair<int, Symbol>, int> state_transitions;
-    std::vector<std::map<Symbol, ActionEntry>> action_goto;
+    // built from the table view by set_table_layout(COMPRESSED)
+    SLR::CompressedTables compressed_tables;
+    bool use_compressed = false;
 
-    /* ================ PARSING STATE =========================== */
-    std::string parse_log_path = "parse_log.csv";
-    std::ostream *parse_log_stream = nullptr;
+    // dense cell, states are numbered the same in both layouts
+    inline const ActionEntry& action(int state, Symbol s) const {
+        return action_table[state * numSymbols + s];
+    }
 
-    mathLexer lexer;
-    std::vector<std::pair<int, Symbol>> stateStack;
-    AST::NodePtr root;
+public:
+    ParseTables();
+    ParseTables(const ParseTables&) = delete;
+    ParseTables& operator=(const ParseTables&) = delete;
+
+    /// @brief Replace grammar with one loaded from BNF file (see Grammar::load)
+    /// Tables must then be built with init(TableSource::RUNTIME)
+    /// or loaded with init_from_file()
+    /// @return 0 on success
+    int load_grammar(const std::string& path);
+    int load_grammar(std::istream& in);
+
+    /// @brief Make reducer available to productions tagged '@name'
+    /// Built-in actions (binop, paren, numid) are bound by default.
+    /// Call before init()
+    void bind_action(const std::string& name, reduceFunc *reduce);
+
+    enum class TableSource { COMPILED, RUNTIME };
+
+    /// @brief Set up action and goto tables
+    /// COMPILED uses tables generated at compile time from builtin_grammar,
+    /// RUNTIME builds canonic states, FIRST, FOLLOW and tables from scratch
+    /// (needed by dump_tables and for loaded grammars).
+    /// Lookahead::LALR accepts more grammars with the same number of states,
+    /// it requires RUNTIME since compiled tables are SLR(1)
+    /// @return number of grammar conflicts, -1 on other errors
+    int init(TableSource source = TableSource::COMPILED, Lookahead lookahead = Lookahead::SLR);
+
+    const TableStats& table_stats() const {
+        return stats;
+    }
+
+    /// @brief Map binary table file written by export_binary_tables()
+    /// and parse straight from it. File must be built for the same grammar
+    /// @return 0 on success, -1 if file can't be mapped or doesn't match grammar
+    int init_from_file(const std::string& path);
+
+    enum class TableLayout { DENSE, COMPRESSED };
+
+    /// @brief Choose tables read by parse(), call after init().
+    /// COMPRESSED packs current tables with default reductions and row
+    /// displacement (see table_layout.hpp), init() switches back to DENSE
+    /// @return 0 on success, -1 if tables are not initialized
+    int set_table_layout(TableLayout layout);
 
-    void report_error(int state, const Token& tok);
-    void print_parse_state(std::ostream& os, char delimeter = ',');
+    /// @brief Write current tables in binary format (see table_file.hpp)
+    /// @return 0 on success
+    int export_binary_tables(const std::string& path) const;
 
+    /// @brief Print FIRST and FOLLOW sets, canonic states to standard output
+    /// Dump action/goto table as csv table to file
+    void dump_tables(const std::string action_goto_path) const;
+};
+
+
+// @brief Parse state over shared tables: lexer, stacks and the last AST.
+// Cheap to create, one per thread. Tables must outlive the parser
+// and must not be re-initialized while it parses
+class Parser {
 public:
-    /// @brief Compute action and goto tables
-    int init();
+    using Symbol = ParseTables::Symbol;
+    using ActionEntry = ParseTables::ActionEntry;
+
+    explicit Parser(const ParseTables& tables): tables(tables) {
+        lexer.set_symbol_map(tables.grammar.tokens);
+        direct_lexer.set_symbol_map(tables.grammar.tokens);
+        push_lexer.set_symbol_map(tables.grammar.tokens);
+    }
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
 
     void set_log_stream(std::ostream& os);
+    /// @brief Where lexical and syntax errors are reported, std::cout by default.
+    /// nullptr disables the messages
+    void set_error_stream(std::ostream *os);
+
+    // @brief Lexer of in-memory input: parse(string), parse_view() and parse_batch().
+    // Streams are always read by the flex lexer. All produce the same tokens.
+    // TOKEN_BUFFER: DirectLexer tokenizes the whole input into a TokenBuffer first,
+    // then the LR loop runs over it
+    enum class LexerBackend {FLEX, DIRECT, TOKEN_BUFFER};
+    void set_lexer_backend(LexerBackend backend) { lexer_backend = backend; }
+
+    // @brief Where reducers build the AST. SHARED: separate nodes, get_root().
+    // ARENA: one AST::Tree per result, get_tree(). POSTFIX: no nodes, reducers
+    // append records in postfix order, get_postfix(). DAG: nodes from get_dag_builder(),
+    // identical subtrees of all expressions parsed so far are one node, get_root().
+    // Built-in reducers support all, reducers bound with bind_action() see
+    // NodeIndex values in ARENA and POSTFIX modes
+    enum class AstStorage {SHARED, ARENA, POSTFIX, DAG};
+    void set_ast_storage(AstStorage storage) { ast_storage = storage; }
+
+    // @brief Bounds on one expression, the parse fails with BAD_INPUT when one is exceeded.
+    // Parse stacks and the AST grow with them, so limits bound memory of hostile input
+    struct Limits {
+        std::size_t max_tokens = SIZE_MAX; // tokens of the expression, END included
+        std::size_t max_depth = SIZE_MAX;  // parse stack entries: open parentheses, pending operators
+    };
+    void set_limits(const Limits& new_limits) { limits = new_limits; }
 
-    enum class ParseStatus {SUCCESS = 0, BAD_INPUT, LEXICAL_ERR, SYNTAX_ERR, FATAL_ERR};
+    // INCOMPLETE: feed() took the bytes, the expression isn't finished yet
+    enum class ParseStatus {SUCCESS = 0, BAD_INPUT, LEXICAL_ERR, SYNTAX_ERR, FATAL_ERR, INCOMPLETE};
 
     /// @brief Parse text and build AST
     /// @return 0 on success, positive integer otherwise
@@ -168,7 +442,38 @@ public:
     ParseStatus parse();
     ParseStatus parse(const std::string& expr);
     ParseStatus parse(std::istream& in);
+    /// @brief Parse the whole file as one expression. File is mapped (or read in
+    /// large blocks if it can't be) and lexed in place, not through std::istream
     ParseStatus parse_file(const std::string& path);
+    /// @brief Parse characters in place, expr must stay alive during the call
+    ParseStatus parse_view(std::string_view expr);
+    /// @brief Parse one expression of a buffer filled by ParseTables::tokenize(),
+    /// starting at token pos. pos is moved past the END of the expression
+    ParseStatus parse_tokens(const TokenBuffer& tokens, std::size_t& pos);
+
+    // @brief Per-item results of parse_batch, parallel to its input
+    struct BatchResult {
+        std::vector<ParseStatus> status;
+        std::vector<AST::NodePtr> roots; // null unless status is SUCCESS, always null in ARENA and POSTFIX modes
+
+        std::size_t size() const { return status.size(); }
+    };
+
+    /// @brief Parse every expression separately, as parse(expr) would.
+    /// Lexer buffer, parse stacks and result vectors are reused, so in steady state
+    /// only AST nodes are allocated. Root is left empty
+    void parse_batch(std::span<const std::string_view> exprs, BatchResult& results);
+    BatchResult parse_batch(std::span<const std::string_view> exprs);
+
+    /// @brief Push parsing: input of one expression comes in chunks of any size,
+    /// tokens may be split between them. Bytes are lexed and parsed as they arrive,
+    /// only lexemes of the expression are kept, so the chunk can be dropped after the call.
+    /// @return INCOMPLETE while no error is found, the error after that.
+    /// Root is erased by the first feed() of an expression
+    ParseStatus feed(std::string_view bytes);
+    /// @brief End of the expression fed so far
+    /// @return final status, next feed() starts a new expression
+    ParseStatus finish();
 
     /// @brief Get root of AST build from previous parse() call
     AST::NodePtr get_root() {
@@ -179,11 +484,141 @@ public:
         return root;
     }
 
-    /// @brief Print FIRST and FOLLOW sets, canonic states to standard output
-    /// Dump action/goto table as csv table to file
-    void dump_tables(const std::string action_goto_path);
+    /// @brief AST of the previous parse in AstStorage::ARENA mode,
+    /// valid until the next parse
+    const AST::Tree& get_tree() const {
+        return tree;
+    }
 
+    /// @brief Move the tree out, it stays valid after the next parse
+    AST::Tree take_tree() {
+        return std::exchange(tree, AST::Tree{});
+    }
+
+    /// @brief Nodes of AstStorage::DAG mode, kept between parses until cleared
+    AST::DagBuilder& get_dag_builder() {
+        return dag;
+    }
+
+    /// @brief Expression of the previous parse in AstStorage::POSTFIX mode,
+    /// empty unless it succeeded. Valid until the next parse
+    std::span<const AST::PostfixItem> get_postfix() const {
+        return {postfix.data(), postfix_end};
+    }
+
+private:
+    const ParseTables& tables;
+
+    /* ================ PARSING STATE =========================== */
+    std::ostream *parse_log_stream = nullptr;
+    std::ostream *error_stream = &std::cout;
+
+    mathLexer lexer;
+    DirectLexer direct_lexer;
+    LexerBackend lexer_backend = LexerBackend::DIRECT;
+    TokenBuffer token_buffer;
+    std::vector<std::pair<int, Symbol>> stateStack;
+    ValueStack valueStack;
+    AST::NodePtr root;
+    AstStorage ast_storage = AstStorage::SHARED;
+    AST::Tree tree;
+    AST::Postfix postfix;
+    std::size_t postfix_end = 0; // records of the accepted expression
+    AST::DagBuilder dag;
+    AST::SymbolCache symbol_cache{AST::symbols()};
+    Limits limits;
+    std::size_t token_count = 0; // of the current expression
+
+    // erases results of the previous parse
+    void clear_result() {
+        root = nullptr;
+        tree.clear();
+        postfix.clear();
+        postfix_end = 0;
+    }
+
+    // state of feed() between calls. Pull parsing abandons it
+    PushLexer push_lexer;
+    bool push_active = false;
+    ParseStatus push_status = ParseStatus::INCOMPLETE;
+
+    // input of parse(string) and parse_batch() for the flex lexer, reused between calls
+    ViewStreamBuf view_buf;
+    std::istream view_stream{&view_buf};
+
+    void report_error(int state, const Token& tok, std::string_view source);
+    void report_depth(const Token& tok);
+    void print_parse_state(std::ostream& os, ActionEntry entry, const Token& buf_tok, std::string_view source,
+                           char delimeter = ',');
+
+    // parse loop over DenseTables or CompressedTables and any lexer
+    template <typename Tables, TokenSource Lexer>
+    ParseStatus parse_loop(const Tables& layout, Lexer& lex);
+    template <TokenSource Lexer>
+    ParseStatus parse_loop(Lexer& lex);
+
+    void start_stacks();
+    /// @brief Reduce until tok is shifted
+    /// @return INCOMPLETE after the shift, final status on accept or error
+    template <typename Tables>
+    ParseStatus push_token(const Tables& layout, const Token& tok, Symbol s, std::string_view source);
+
+    template <typename Tables>
+    ParseStatus parse_tokens(const Tables& layout, const TokenBuffer& tokens, std::size_t& pos);
+
+    void start_push();
+    /// @brief Parse tokens push_lexer has completed
+    template <typename Tables>
+    ParseStatus push_tokens(const Tables& layout);
+    ParseStatus push_tokens();
+};
+
+
+// @brief Tables with their own parser, for single-threaded use
+class SyntaxAnalyzer : public ParseTables {
+    Parser parser{*this};
+
+public:
+    using ParseStatus = Parser::ParseStatus;
+    using BatchResult = Parser::BatchResult;
+    using LexerBackend = Parser::LexerBackend;
+    using AstStorage = Parser::AstStorage;
+
+    void set_log_stream(std::ostream& os) { parser.set_log_stream(os); }
+    void set_lexer_backend(LexerBackend backend) { parser.set_lexer_backend(backend); }
+    void set_ast_storage(AstStorage storage) { parser.set_ast_storage(storage); }
+    void set_limits(const Parser::Limits& limits) { parser.set_limits(limits); }
+
+    ParseStatus parse() { return parser.parse(); }
+    ParseStatus parse(const std::string& expr) { return parser.parse(expr); }
+    ParseStatus parse(std::istream& in) { return parser.parse(in); }
+    ParseStatus parse_file(const std::string& path) { return parser.parse_file(path); }
+    ParseStatus feed(std::string_view bytes) { return parser.feed(bytes); }
+    ParseStatus finish() { return parser.finish(); }
+
+    void parse_batch(std::span<const std::string_view> exprs, BatchResult& results) {
+        parser.parse_batch(exprs, results);
+    }
+    BatchResult parse_batch(std::span<const std::string_view> exprs) {
+        return parser.parse_batch(exprs);
+    }
+
+    AST::NodePtr get_root() {
+        return parser.get_root();
+    }
+
+    const AST::NodePtr peek_root() {
+        return parser.peek_root();
+    }
+
+    const AST::Tree& get_tree() const {
+        return parser.get_tree();
+    }
+
+    std::span<const AST::PostfixItem> get_postfix() const {
+        return parser.get_postfix();
+    }
 };
 
-std::ostream& operator<<(std::ostream& os, SyntaxAnalyzer::Symbol item);
-std::ostream& operator<<(std::ostream& os, SyntaxAnalyzer::Item item);
+/// @brief Name of the built-in grammar symbol
+std::ostream& operator<<(std::ostream& os, ParseTables::Symbol item);
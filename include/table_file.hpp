@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "slr_table.hpp"
+
+/*
+    Binary table file layout (native byte order, all offsets from file start):
+
+        TableFileHeader
+        ActionEntry  actions[n_states * n_symbols]   at actions_offset
+        ReduceInfo   prods[n_productions]            at prods_offset
+        uint32_t     name_offsets[n_symbols]         at names_offset,
+                                                     relative to names_offset
+        char         names[]                         NUL-terminated symbol names
+
+    Sections are 8-byte aligned, so the parser reads them in place from mmap
+*/
+namespace SLR {
+
+    constexpr char table_file_magic[4] = {'S', 'L', 'R', 'T'};
+    constexpr std::uint32_t table_file_version = 1;
+    constexpr std::uint32_t table_file_byte_order = 0x01020304;
+
+    struct TableFileHeader {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint32_t n_states;
+        std::uint32_t n_symbols;
+        std::uint32_t n_productions;
+        std::uint32_t actions_offset;
+        std::uint32_t prods_offset;
+        std::uint32_t names_offset;
+        std::uint32_t file_size;
+    };
+
+    /// @brief Write tables to path in the format above
+    /// @return 0 on success
+    int write_table_file(const std::string& path,
+                         std::size_t n_states, std::size_t n_symbols, const ActionEntry *actions,
+                         std::size_t n_productions, const ReduceInfo *prods,
+                         const std::vector<std::string>& symbol_names);
+
+    // @brief Read-only mapping of a table file, unmapped on destruction
+    class MappedTableFile {
+        const char *data_ = nullptr;
+        std::size_t size_ = 0;
+
+    public:
+        MappedTableFile() = default;
+        MappedTableFile(const MappedTableFile&) = delete;
+        MappedTableFile& operator=(const MappedTableFile&) = delete;
+        ~MappedTableFile();
+
+        /// @brief Map file and validate header and section bounds
+        /// @return 0 on success
+        int open(const std::string& path);
+
+        const TableFileHeader& header() const {
+            return *reinterpret_cast<const TableFileHeader*>(data_);
+        }
+
+        const ActionEntry *actions() const {
+            return reinterpret_cast<const ActionEntry*>(data_ + header().actions_offset);
+        }
+
+        const ReduceInfo *reduce_info() const {
+            return reinterpret_cast<const ReduceInfo*>(data_ + header().prods_offset);
+        }
+
+        const char *symbol_name(std::size_t sym) const;
+    };
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "slr_table.hpp"
+
+/*
+    Layouts of action/goto tables read by the parse loop. Both provide
+
+        ActionEntry action(int state, int terminal)
+        int goto_state(int state, int nonterminal)
+
+    DenseTables is a view of the flat state x symbol array.
+    CompressedTables keeps only meaningful cells:
+        - the most frequent reduction of a state becomes its default
+          and is taken on every terminal missing from the row
+        - remaining terminal cells of all states share one array (comb vector),
+          row r starts at base[r] and cell is valid if check equals r
+        - GOTO cells are packed the same way by nonterminal columns,
+          the most frequent target state of a column is its default
+    Default reductions may perform a few extra reductions before a syntax error
+    is detected, but never shift an erroneous token
+*/
+namespace SLR {
+
+    // @brief View of the dense row-major table
+    struct DenseTables {
+        const ActionEntry *cells = nullptr;
+        int n_symbols = 0;
+
+        ActionEntry action(int state, int sym) const {
+            return cells[state * n_symbols + sym];
+        }
+
+        int goto_state(int state, int lhs) const {
+            return cells[state * n_symbols + lhs].val;
+        }
+    };
+
+    // @brief Sparse rows packed into one array by row displacement
+    template <typename V>
+    struct CombVector {
+        std::vector<std::int32_t> base;
+        std::vector<std::int16_t> check; // owning row, -1 for free cells
+        std::vector<V> value;
+
+        const V *find(int row, int col) const {
+            std::size_t i = base[row] + col;
+            return check[i] == row ? &value[i] : nullptr;
+        }
+
+        /// @brief Place rows of {column, value} cells, first fit from the fullest row
+        /// Columns must be less than n_cols
+        void pack(const std::vector<std::vector<std::pair<int, V>>>& rows, int n_cols) {
+            std::vector<int> order(rows.size());
+            for (std::size_t r = 0; r < rows.size(); r++) order[r] = r;
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+                return rows[a].size() > rows[b].size();
+            });
+
+            base.assign(rows.size(), 0);
+            check.assign(n_cols, -1);
+            value.assign(n_cols, V{});
+
+            for (int r: order) {
+                if (rows[r].empty()) continue;
+
+                std::size_t b = 0;
+                auto fits = [&](std::size_t b) {
+                    for (auto [col, v]: rows[r]) {
+                        if (b + col < check.size() && check[b + col] != -1) return false;
+                    }
+                    return true;
+                };
+                while (!fits(b)) b++;
+
+                // every row must be addressable with any column
+                if (b + n_cols > check.size()) {
+                    check.resize(b + n_cols, -1);
+                    value.resize(b + n_cols, V{});
+                }
+
+                base[r] = b;
+                for (auto [col, v]: rows[r]) {
+                    check[b + col] = r;
+                    value[b + col] = v;
+                }
+            }
+        }
+
+        std::size_t size_bytes() const {
+            return base.size() * sizeof(std::int32_t) + check.size() * sizeof(std::int16_t)
+                 + value.size() * sizeof(V);
+        }
+    };
+
+    struct CompressedTables {
+        CombVector<ActionEntry> actions;         // rows are states, columns are terminals
+        std::vector<std::int16_t> default_reduce; // production id for every state, -1 if none
+        CombVector<std::int16_t> gotos;          // rows are nonterminals, columns are states
+        std::vector<std::int16_t> default_goto;   // target state for every nonterminal
+
+        ActionEntry action(int state, int sym) const {
+            if (const ActionEntry *entry = actions.find(state, sym)) return *entry;
+
+            int prod = default_reduce[state];
+            return prod < 0 ? ActionEntry{} : ActionEntry{REDUCE, prod};
+        }
+
+        int goto_state(int state, int lhs) const {
+            if (const std::int16_t *target = gotos.find(lhs, state)) return *target;
+            return default_goto[lhs];
+        }
+
+        std::size_t size_bytes() const {
+            return actions.size_bytes() + gotos.size_bytes()
+                 + (default_reduce.size() + default_goto.size()) * sizeof(std::int16_t);
+        }
+    };
+
+    /// @brief Compress dense row-major table, is_term is indexed by symbol
+    CompressedTables compress_tables(const ActionEntry *cells, std::size_t n_states, std::size_t n_symbols,
+                                     const std::vector<std::uint8_t>& is_term);
+};
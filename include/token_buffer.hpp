@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "lexer.hpp"
+
+// @brief Tokens of whole expressions in structure-of-arrays form, filled by
+// ParseTables::tokenize() before parsing. Every expression ends with an END token.
+// The LR loop takes symbol codes from here instead of converting tokens as they come
+struct TokenBuffer {
+    std::string_view source; // text offsets refer to
+
+    std::vector<std::int32_t> symbols; // grammar symbols of the tables that filled the buffer, see SymbolMap
+    std::vector<TokenType> types;
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> lengths;
+    std::vector<std::int32_t> values; // number value, for UNKNOWN 1 if it is a number out of range
+    std::vector<std::int32_t> lines;
+    std::vector<std::int32_t> columns;
+
+    std::size_t size() const { return symbols.size(); }
+
+    /// @brief Drop all tokens, keeping the storage, new tokens refer to text
+    void clear(std::string_view text) {
+        source = text;
+        symbols.clear();
+        types.clear();
+        offsets.clear();
+        lengths.clear();
+        values.clear();
+        lines.clear();
+        columns.clear();
+    }
+
+    /// @brief Append tok, its offset is moved by base
+    void push_back(const Token& tok, std::uint32_t base) {
+        symbols.push_back(tok.symbol_);
+        types.push_back(tok.type_);
+        offsets.push_back(base + tok.offset_);
+        lengths.push_back(tok.length_);
+        values.push_back(tok.type_ == TokenType::UNKNOWN ? tok.out_of_range : tok.int_val);
+        lines.push_back(tok.line_);
+        columns.push_back(tok.pos_);
+    }
+
+    /// @brief Token i as a lexer would have returned it, with offset into source
+    Token token(std::size_t i) const {
+        Token tok{TokenType::END, "", offsets[i], lines[i], columns[i]};
+        tok.type_ = types[i];
+        tok.symbol_ = symbols[i];
+        tok.length_ = lengths[i];
+        switch (tok.type_) {
+            case TokenType::NUMBER: tok.int_val = values[i]; break;
+            case TokenType::OPERATOR: tok.op_char = source[tok.offset_]; break;
+            case TokenType::UNKNOWN: tok.out_of_range = values[i]; break;
+            default: break;
+        }
+        return tok;
+    }
+};
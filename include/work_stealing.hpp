@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SLR {
+
+    // @brief Task indices of one worker. The owner takes from the front,
+    // thieves take from the back, so the owner walks its range in order
+    class TaskDeque {
+        std::deque<std::size_t> tasks;
+        std::mutex mutex;
+
+    public:
+        void push(std::size_t task) {
+            std::lock_guard lock(mutex);
+            tasks.push_back(task);
+        }
+
+        bool pop(std::size_t& task) {
+            std::lock_guard lock(mutex);
+            if (tasks.empty()) return false;
+            task = tasks.front();
+            tasks.pop_front();
+            return true;
+        }
+
+        bool steal(std::size_t& task) {
+            std::lock_guard lock(mutex);
+            if (tasks.empty()) return false;
+            task = tasks.back();
+            tasks.pop_back();
+            return true;
+        }
+    };
+
+    /// @brief Run fn(task, worker) for every task in [0, n_tasks) on n_workers threads.
+    /// Each worker starts with a contiguous range of tasks and steals from the others
+    /// when its own range is done. Returns when all tasks are finished
+    template <typename F>
+    void run_work_stealing(std::size_t n_tasks, unsigned n_workers, F&& fn) {
+        if (n_workers <= 1 || n_tasks <= 1) {
+            for (std::size_t task = 0; task < n_tasks; task++) fn(task, 0u);
+            return;
+        }
+
+        std::vector<TaskDeque> queues(n_workers);
+        for (unsigned w = 0; w < n_workers; w++) {
+            for (std::size_t task = n_tasks * w / n_workers; task < n_tasks * (w + 1) / n_workers; task++) {
+                queues[w].push(task);
+            }
+        }
+
+        // no tasks are added after start, so a worker that finds every queue empty is done
+        auto worker = [&](unsigned w) {
+            std::size_t task;
+            while (true) {
+                bool found = queues[w].pop(task);
+                for (unsigned i = 1; !found && i < n_workers; i++) {
+                    found = queues[(w + i) % n_workers].steal(task);
+                }
+                if (!found) return;
+
+                fn(task, w);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned w = 1; w < n_workers; w++) threads.emplace_back(worker, w);
+        worker(0);
+        for (std::thread& thread: threads) thread.join();
+    }
+};
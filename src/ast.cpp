@@ -1,108 +1,163 @@
 #include "AST.hpp"
-#include <iostream>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <ostream>
 
 namespace AST {
-    // initializing id for nodes
-    std::size_t Node::next_id = 0;
-
-    void BinOpNode::dump(std::ostream& os, DumpType type) {
-        auto label = [&]() {
-            switch(op) {
-                case PLUS: return '+';
-                case MINUS: return '-';
-                case DIV: return '/';
-                case MUL: return '*';
-                default: return '?';
-            }
-        };
-
-        switch(type) {
-            case GRAPHVIZ:
-            // dumping itself
-            os << "  node" << id << " [label=\"" << label()
-                << "\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n";
-
-            // dumping children
-            if (left) {
-                left->dump(os, type);
-                os << "  node" << id << " -> node" << left->id
-                    << " [label=\"left\"];\n";
-            }
-            if (right) {
-                right->dump(os, type);
-                os << "  node" << id << " -> node" << right->id
-                    << " [label=\"right\"];\n";
-            }
-
-            break;
-
-            case SERIALIZE:
-            os << "(BINOP:" << label();
-            if (left) left->dump(os, type);
-            if (right) right->dump(os, type);
-            os << ")";
-            break;
-            default:
-            std::cerr << "Can't dump BinOp to this type\n";
-            break;
+    // ids are handed out to threads in blocks, so parallel parsers
+    // don't contend on one counter. First id is 1
+    static constexpr std::size_t id_block_size = 4096;
+    static std::atomic<std::size_t> next_id_block{0};
+
+    std::size_t Node::new_id() {
+        thread_local std::size_t last_id = 0;
+        thread_local std::size_t block_end = 0;
+
+        if (last_id == block_end) {
+            last_id = next_id_block.fetch_add(id_block_size, std::memory_order_relaxed);
+            block_end = last_id + id_block_size;
         }
+        return ++last_id;
     }
 
-    void IdNode::dump(std::ostream& os, DumpType type) {
-        switch(type) {
-            case GRAPHVIZ:
-            os << "  node" << id << " [label=\"" << "ID:" << id_name
-                << "\", shape=rectangle, style=filled, fillcolor=\"#f1e364\"];\n";
-            break;
-            case SERIALIZE:
-            os << "(ID:" << id_name << ")";
-            break;
-            default:
-            std::cerr << "Can't dump IdNode to this type\n";
-            break;
+    char label(Operator op) {
+        switch(op) {
+            case PLUS: return '+';
+            case MINUS: return '-';
+            case DIV: return '/';
+            case MUL: return '*';
+            default: return '?';
         }
     }
 
-    void NumNode::dump(std::ostream& os, DumpType type) {
-        switch(type) {
-            case GRAPHVIZ:
-            os << "  node" << id << " [label=\"" << "NUM:" << num
-                << "\", shape=rectangle, style=filled, fillcolor=\"#38d878\"];\n";
-            break;
-            case SERIALIZE:
-            os << "(NUM:" << num << ")";
-            break;
-            default:
-            std::cerr << "Can't dump NumNode to this type\n";
-            break;
+    static void dumpGraphviz(const NodePtr& root, std::ostream& os) {
+        walk(root,
+            [&](const Node& node) {
+                visit(Overloaded{
+                    [&](const BinOpNode& binop) {
+                        os << "  node" << binop.id << " [label=\"" << label(binop.op)
+                            << "\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n";
+                    },
+                    [&](const IdNode& id) {
+                        os << "  node" << id.id << " [label=\"" << "ID:" << id.name()
+                            << "\", shape=rectangle, style=filled, fillcolor=\"#f1e364\"];\n";
+                    },
+                    [&](const NumNode& num) {
+                        os << "  node" << num.id << " [label=\"" << "NUM:" << num.num
+                            << "\", shape=rectangle, style=filled, fillcolor=\"#38d878\"];\n";
+                    },
+                }, node);
+            },
+            // edge to the child after its subtree
+            [&](const BinOpNode& binop, Side side) {
+                if (side == Side::LEFT && binop.left) {
+                    os << "  node" << binop.id << " -> node" << binop.left->id
+                        << " [label=\"left\"];\n";
+                } else if (side == Side::RIGHT && binop.right) {
+                    os << "  node" << binop.id << " -> node" << binop.right->id
+                        << " [label=\"right\"];\n";
+                }
+            });
+    }
+
+    static void dumpString(const NodePtr& root, std::ostream& os) {
+        walk(root,
+            [&](const Node& node) {
+                visit(Overloaded{
+                    [&](const BinOpNode& binop) { os << "(BINOP:" << label(binop.op); },
+                    [&](const IdNode& id) { os << "(ID:" << id.name() << ")"; },
+                    [&](const NumNode& num) { os << "(NUM:" << num.num << ")"; },
+                }, node);
+            },
+            [&](const BinOpNode&, Side side) {
+                if (side == Side::RIGHT) os << ")";
+            });
+    }
+
+    BinOpNode::~BinOpNode() {
+        // children owned only by this node are moved out before they are destroyed,
+        // so each destructor below finds its children gone and doesn't recurse
+        std::vector<NodePtr> pending;
+        auto take = [&](NodePtr& child) {
+            if (child && child.use_count() == 1) pending.push_back(std::move(child));
+        };
+        take(left);
+        take(right);
+
+        while (!pending.empty()) {
+            NodePtr node = std::move(pending.back());
+            pending.pop_back();
+            if (node->kind == NodeKind::BINOP) {
+                auto& binop = static_cast<BinOpNode&>(*node);
+                take(binop.left);
+                take(binop.right);
+            }
         }
     }
 
+    std::size_t hash_binop(std::size_t left, Operator op, std::size_t right) {
+        std::size_t h = std::hash<std::size_t>{}(left) * 0x9E3779B97F4A7C15ull;
+        h = (h ^ right) * 0xBF58476D1CE4E5B9ull;
+        return h ^ (std::size_t(op) + 1) * 0x94D049BB133111EBull;
+    }
+
+    std::size_t hash_leaf(NodeKind kind, std::int32_t value) {
+        std::uint64_t h = (std::uint64_t(std::uint32_t(value)) << 8 | std::uint8_t(kind)) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+    }
+
     NodePtr makeBinOp(NodePtr left, Operator op, NodePtr right) {
         auto node = std::make_shared<BinOpNode>();
-        node->left = left; node->right = right;
+        node->hash = hash_binop(left ? left->hash : 0, op, right ? right->hash : 0);
+        node->left = std::move(left);
+        node->right = std::move(right);
         node->op = op;
-
-        if (left) left->parent = node;
-        if (right) right->parent = node;
-
         return node;
     }
 
-    NodePtr makeId(const std::string& name) {
+    NodePtr makeId(std::uint32_t name_id) {
         auto node = std::make_shared<IdNode>();
-        node->id_name = name;
+        node->name_id = name_id;
+        node->hash = hash_leaf(NodeKind::ID, name_id);
         return node;
     }
 
+    NodePtr makeId(std::string_view name) {
+        return makeId(symbols().intern(name));
+    }
+
     NodePtr makeNum(int value) {
         auto node = std::make_shared<NumNode>();
         node->num = value;
+        node->hash = hash_leaf(NodeKind::NUM, value);
         return node;
     }
 
+    bool equal(const NodePtr& a, const NodePtr& b) {
+        std::vector<std::pair<const Node*, const Node*>> pending{{a.get(), b.get()}};
+        while (!pending.empty()) {
+            auto [x, y] = pending.back();
+            pending.pop_back();
+
+            if (x == y) continue; // same node or both null
+            if (!x || !y || x->hash != y->hash || x->kind != y->kind) return false;
+
+            bool same = visit(Overloaded{
+                [&](const BinOpNode& binop) {
+                    const auto& other = static_cast<const BinOpNode&>(*y);
+                    pending.push_back({binop.left.get(), other.left.get()});
+                    pending.push_back({binop.right.get(), other.right.get()});
+                    return binop.op == other.op;
+                },
+                [&](const IdNode& id) { return id.name_id == static_cast<const IdNode&>(*y).name_id; },
+                [&](const NumNode& num) { return num.num == static_cast<const NumNode&>(*y).num; },
+            }, *x);
+            if (!same) return false;
+        }
+        return true;
+    }
+
 
     void dumpTreeAsGraphviz(const NodePtr& root, std::ostream& os) {
         if (!root) {
@@ -118,7 +173,7 @@ namespace AST {
         os << "  edge [fontname=\"Courier\", fontsize=8];\n";
         os << "\n";
 
-        root->dump(os, GRAPHVIZ);
+        dumpGraphviz(root, os);
 
         os << "}\n";
     }
@@ -129,7 +184,7 @@ namespace AST {
             return;
         }
 
-        root->dump(os, SERIALIZE);
+        dumpString(root, os);
     }
 
 };
@@ -0,0 +1,147 @@
+#include "ast_arena.hpp"
+
+namespace AST {
+
+    NodeIndex Tree::add_binop(NodeIndex left, Operator op, NodeIndex right) {
+        NodeIndex i = nodes.size();
+        nodes.push_back({.id = Node::new_id(), .left = left, .right = right, .kind = NodeKind::BINOP, .op = op});
+
+        if (left != no_node) nodes[left].parent = i;
+        if (right != no_node) nodes[right].parent = i;
+        return i;
+    }
+
+    NodeIndex Tree::add_id(std::uint32_t name_id) {
+        nodes.push_back({.id = Node::new_id(), .value = std::int32_t(name_id), .kind = NodeKind::ID});
+        return nodes.size() - 1;
+    }
+
+    NodeIndex Tree::add_num(int value) {
+        nodes.push_back({.id = Node::new_id(), .value = value, .kind = NodeKind::NUM});
+        return nodes.size() - 1;
+    }
+
+    NodeIndex copy_to_tree(const NodePtr& node, Tree& tree) {
+        // fold gives R{} for null children, which must be no_node rather than index 0
+        struct Copy {
+            NodeIndex i = no_node;
+        };
+        return fold<Copy>(node, Overloaded{
+            [&](const BinOpNode& binop, Copy left, Copy right) {
+                NodeIndex copy = tree.add_binop(left.i, binop.op, right.i);
+                tree[copy].id = binop.id;
+                return Copy{copy};
+            },
+            [&](const IdNode& id) {
+                NodeIndex copy = tree.add_id(id.name_id);
+                tree[copy].id = id.id;
+                return Copy{copy};
+            },
+            [&](const NumNode& num) {
+                NodeIndex copy = tree.add_num(num.num);
+                tree[copy].id = num.id;
+                return Copy{copy};
+            },
+        }).i;
+    }
+
+    NodePtr to_node(const Tree& tree, NodeIndex i) {
+        std::vector<NodePtr> nodes; // of finished subtrees
+        walk(tree, i,
+            [&](NodeIndex j) {
+                const TreeNode& n = tree[j];
+                if (n.kind == NodeKind::ID) nodes.push_back(makeId(std::uint32_t(n.value)));
+                else if (n.kind == NodeKind::NUM) nodes.push_back(makeNum(n.value));
+                else return;
+                nodes.back()->id = n.id;
+            },
+            [&](NodeIndex j, Side side) {
+                const TreeNode& n = tree[j];
+                if (side == Side::LEFT) {
+                    if (n.left == no_node) nodes.push_back(nullptr);
+                    return;
+                }
+                if (n.right == no_node) nodes.push_back(nullptr);
+
+                NodePtr right = std::move(nodes.back());
+                nodes.pop_back();
+                nodes.back() = makeBinOp(nodes.back(), n.op, right);
+                nodes.back()->id = n.id;
+            });
+
+        if (nodes.empty()) return nullptr;
+        return nodes.back();
+    }
+
+    static void dumpGraphviz(const Tree& tree, std::ostream& os) {
+        walk(tree, tree.root,
+            [&](NodeIndex i) {
+                const TreeNode& n = tree[i];
+                switch (n.kind) {
+                    case NodeKind::BINOP:
+                        os << "  node" << n.id << " [label=\"" << label(n.op)
+                            << "\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n";
+                        break;
+                    case NodeKind::ID:
+                        os << "  node" << n.id << " [label=\"" << "ID:" << symbols().name(n.value)
+                            << "\", shape=rectangle, style=filled, fillcolor=\"#f1e364\"];\n";
+                        break;
+                    case NodeKind::NUM:
+                        os << "  node" << n.id << " [label=\"" << "NUM:" << n.value
+                            << "\", shape=rectangle, style=filled, fillcolor=\"#38d878\"];\n";
+                        break;
+                }
+            },
+            [&](NodeIndex i, Side side) {
+                const TreeNode& n = tree[i];
+                if (side == Side::LEFT && n.left != no_node) {
+                    os << "  node" << n.id << " -> node" << tree[n.left].id << " [label=\"left\"];\n";
+                } else if (side == Side::RIGHT && n.right != no_node) {
+                    os << "  node" << n.id << " -> node" << tree[n.right].id << " [label=\"right\"];\n";
+                }
+            });
+    }
+
+    static void dumpString(const Tree& tree, std::ostream& os) {
+        walk(tree, tree.root,
+            [&](NodeIndex i) {
+                const TreeNode& n = tree[i];
+                switch (n.kind) {
+                    case NodeKind::BINOP: os << "(BINOP:" << label(n.op); break;
+                    case NodeKind::ID: os << "(ID:" << symbols().name(n.value) << ")"; break;
+                    case NodeKind::NUM: os << "(NUM:" << n.value << ")"; break;
+                }
+            },
+            [&](NodeIndex, Side side) {
+                if (side == Side::RIGHT) os << ")";
+            });
+    }
+
+    void dumpTreeAsGraphviz(const Tree& tree, std::ostream& os) {
+        if (tree.empty()) {
+            os << "digraph AST {\n";
+            os << "  label=\"Empty tree\";\n";
+            os << "}\n";
+            return;
+        }
+
+        os << "digraph AST {\n";
+        os << "  rankdir=TB;\n";  // Top to Bottom
+        os << "  node [fontname=\"Courier\", fontsize=10];\n";
+        os << "  edge [fontname=\"Courier\", fontsize=8];\n";
+        os << "\n";
+
+        dumpGraphviz(tree, os);
+
+        os << "}\n";
+    }
+
+    void dumpTreeAsString(const Tree& tree, std::ostream& os) {
+        if (tree.empty()) {
+            os << "<EMPTY_TREE>";
+            return;
+        }
+
+        dumpString(tree, os);
+    }
+};
@@ -0,0 +1,200 @@
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include "ast_binary.hpp"
+
+namespace AST {
+
+    static void put_varint(std::vector<std::uint8_t>& out, std::uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(std::uint8_t(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(std::uint8_t(value));
+    }
+
+    int write_binary(const NodePtr& root, std::vector<std::uint8_t>& out) {
+        const std::size_t start = out.size();
+        out.insert(out.end(), binary_magic, binary_magic + sizeof(binary_magic));
+        out.push_back(binary_version);
+
+        if (!root) {
+            out.push_back(std::uint8_t(BinaryOp::NONE));
+            put_varint(out, 0);
+            return 0;
+        }
+
+        // name_id in symbols() -> index in the name table
+        std::unordered_map<std::uint32_t, std::uint32_t> indices;
+        std::vector<std::uint32_t> used;
+        bool bad_operator = false;
+
+        walk(root,
+            [&](const Node& node) {
+                visit(Overloaded{
+                    [&](const BinOpNode& binop) {
+                        // other values would be read back as NUM, ID or NONE opcodes
+                        if (binop.op < PLUS || binop.op > DIV) bad_operator = true;
+                        out.push_back(std::uint8_t(binop.op));
+                    },
+                    [&](const IdNode& id) {
+                        auto [it, added] = indices.try_emplace(id.name_id, used.size());
+                        if (added) used.push_back(id.name_id);
+                        out.push_back(std::uint8_t(BinaryOp::ID));
+                        put_varint(out, it->second);
+                    },
+                    [&](const NumNode& num) {
+                        std::uint32_t value = num.num;
+                        out.push_back(std::uint8_t(BinaryOp::NUM));
+                        put_varint(out, (value << 1) ^ -(value >> 31));
+                    },
+                }, node);
+            },
+            // walk doesn't enter null children, their places are kept by NONE
+            [&](const BinOpNode& binop, Side side) {
+                if (!(side == Side::LEFT ? binop.left : binop.right)) out.push_back(std::uint8_t(BinaryOp::NONE));
+            });
+        if (bad_operator) {
+            out.resize(start);
+            std::cerr << "Can't write an expression tree with an unknown operator\n";
+            return -1;
+        }
+
+        put_varint(out, used.size());
+        for (std::uint32_t name_id: used) {
+            std::string_view name = symbols().name(name_id);
+            put_varint(out, name.size());
+            out.insert(out.end(), name.begin(), name.end());
+        }
+        return 0;
+    }
+
+
+    // varint that ends before end and fits into 32 bits
+    static bool get_varint(const std::uint8_t *&p, const std::uint8_t *end, std::uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p == end) return false;
+            std::uint8_t byte = *p++;
+            if (shift == 28 && byte > 0x0f) return false;
+            value |= std::uint32_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static int bad_image(const char *reason) {
+        std::cerr << "Bad binary AST: " << reason << "\n";
+        return -1;
+    }
+
+    int BinaryReader::open(std::span<const std::uint8_t> data) {
+        bytes = {};
+        names.clear();
+        node_count = 0;
+
+        const std::uint8_t *p = data.data();
+        const std::uint8_t *end = p + data.size();
+        if (data.size() < sizeof(binary_magic) + 1 || std::memcmp(p, binary_magic, sizeof(binary_magic))) {
+            return bad_image("no magic");
+        }
+        p += sizeof(binary_magic);
+        if (*p++ != binary_version) return bad_image("unsupported version");
+
+        // each node fills one open place and a binary node opens two more
+        std::size_t open_places = 1;
+        std::size_t count = 0;
+        std::uint32_t name_refs = 0; // largest name index + 1
+        while (open_places > 0) {
+            if (p == end) return bad_image("truncated tree");
+            auto opcode = BinaryOp(*p++);
+            std::uint32_t operand;
+            open_places--;
+            switch (opcode) {
+                case BinaryOp::PLUS:
+                case BinaryOp::MINUS:
+                case BinaryOp::MUL:
+                case BinaryOp::DIV:
+                    open_places += 2;
+                    break;
+                case BinaryOp::NUM:
+                    if (!get_varint(p, end, operand)) return bad_image("bad number");
+                    break;
+                case BinaryOp::ID:
+                    if (!get_varint(p, end, operand)) return bad_image("bad name index");
+                    if (operand >= name_refs) name_refs = operand + 1;
+                    break;
+                case BinaryOp::NONE:
+                    continue;
+                default:
+                    return bad_image("unknown opcode");
+            }
+            count++;
+        }
+
+        std::uint32_t n_names;
+        if (!get_varint(p, end, n_names)) return bad_image("bad name count");
+        if (n_names < name_refs) return bad_image("name index out of range");
+        if (n_names > std::size_t(end - p)) return bad_image("truncated names");
+        names.reserve(n_names);
+        for (std::uint32_t i = 0; i < n_names; i++) {
+            std::uint32_t length;
+            if (!get_varint(p, end, length) || length > std::size_t(end - p)) return bad_image("truncated names");
+            names.emplace_back(reinterpret_cast<const char*>(p), length);
+            p += length;
+        }
+        if (p != end) return bad_image("trailing bytes");
+
+        bytes = data;
+        node_count = count;
+        return 0;
+    }
+
+    NodePtr BinaryReader::to_node() const {
+        std::vector<std::uint32_t> name_ids;
+        for (std::string_view name: names) name_ids.push_back(symbols().intern(name));
+
+        std::vector<NodePtr> results;   // of finished subtrees, null for NONE
+        std::vector<std::size_t> starts; // results.size() when each open binary node was entered
+        walk(
+            [&](const BinaryNode& node) {
+                switch (node.kind) {
+                    case NodeKind::BINOP: starts.push_back(results.size()); break;
+                    case NodeKind::ID: results.push_back(makeId(name_ids[node.value])); break;
+                    default: results.push_back(makeNum(node.value)); break;
+                }
+            },
+            [&](const BinaryNode& binop, Side side) {
+                // a child that added no result was NONE
+                std::size_t expected = starts.back() + (side == Side::LEFT ? 1 : 2);
+                if (results.size() < expected) results.push_back(nullptr);
+                if (side == Side::LEFT) return;
+
+                NodePtr right = std::move(results.back());
+                results.pop_back();
+                results.back() = makeBinOp(std::move(results.back()), binop.op, std::move(right));
+                starts.pop_back();
+            });
+        return results.empty() ? nullptr : results.back();
+    }
+
+    void dumpTreeAsString(const BinaryReader& tree, std::ostream& os) {
+        if (tree.empty()) {
+            os << "<EMPTY_TREE>";
+            return;
+        }
+
+        tree.walk(
+            [&](const BinaryNode& node) {
+                switch (node.kind) {
+                    case NodeKind::BINOP: os << "(BINOP:" << "+-*/"[node.op]; break;
+                    case NodeKind::ID: os << "(ID:" << node.name << ")"; break;
+                    default: os << "(NUM:" << node.value << ")"; break;
+                }
+            },
+            [&](const BinaryNode&, Side side) {
+                if (side == Side::RIGHT) os << ")";
+            });
+    }
+};
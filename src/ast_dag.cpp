@@ -0,0 +1,69 @@
+#include "ast_dag.hpp"
+
+namespace AST {
+
+    DagBuilder::Shape DagBuilder::shape(const Node& node) {
+        return visit(Overloaded{
+            [](const BinOpNode& binop) {
+                return Shape{NodeKind::BINOP, binop.op, binop.left.get(), binop.right.get(), binop.hash};
+            },
+            [](const IdNode& id) { return Shape{NodeKind::ID, std::int32_t(id.name_id), {}, {}, id.hash}; },
+            [](const NumNode& num) { return Shape{NodeKind::NUM, num.num, {}, {}, num.hash}; },
+        }, node);
+    }
+
+    template <typename Make>
+    NodePtr DagBuilder::find_or_add(const Shape& key, Make&& make) {
+        requests++;
+        auto it = nodes.find(key);
+        if (it != nodes.end()) return *it;
+        return *nodes.insert(make()).first;
+    }
+
+    NodePtr DagBuilder::makeBinOp(NodePtr left, Operator op, NodePtr right) {
+        std::size_t hash = hash_binop(left ? left->hash : 0, op, right ? right->hash : 0);
+        Shape key{NodeKind::BINOP, op, left.get(), right.get(), hash};
+        return find_or_add(key, [&] { return AST::makeBinOp(std::move(left), op, std::move(right)); });
+    }
+
+    NodePtr DagBuilder::makeId(std::uint32_t name_id) {
+        Shape key{NodeKind::ID, std::int32_t(name_id), {}, {}, hash_leaf(NodeKind::ID, name_id)};
+        return find_or_add(key, [&] { return AST::makeId(name_id); });
+    }
+
+    NodePtr DagBuilder::makeId(std::string_view name) {
+        return makeId(symbols().intern(name));
+    }
+
+    NodePtr DagBuilder::makeNum(int value) {
+        Shape key{NodeKind::NUM, value, {}, {}, hash_leaf(NodeKind::NUM, value)};
+        return find_or_add(key, [&] { return AST::makeNum(value); });
+    }
+
+    ParentMap::ParentMap(const NodePtr& root) {
+        if (!root) return;
+
+        parents[root.get()];
+        std::vector<const Node*> pending{root.get()};
+        while (!pending.empty()) {
+            const Node *node = pending.back();
+            pending.pop_back();
+            if (node->kind != NodeKind::BINOP) continue;
+
+            const auto& binop = static_cast<const BinOpNode&>(*node);
+            for (const Node *child: {binop.left.get(), binop.right.get()}) {
+                if (!child) continue;
+                auto [it, first_visit] = parents.try_emplace(child);
+                // both children may be the same node
+                if (it->second.empty() || it->second.back() != &binop) it->second.push_back(&binop);
+                if (first_visit) pending.push_back(child);
+            }
+        }
+    }
+
+    std::span<const BinOpNode* const> ParentMap::of(const Node& node) const {
+        auto it = parents.find(&node);
+        if (it == parents.end()) return {};
+        return it->second;
+    }
+};
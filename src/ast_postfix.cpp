@@ -0,0 +1,49 @@
+#include "ast_postfix.hpp"
+
+namespace AST {
+
+    void to_postfix(const NodePtr& node, Postfix& out) {
+        fold<int>(node, Overloaded{
+            [&](const BinOpNode& binop, int, int) {
+                out.push_back({PostfixOp::BINOP, binop.op});
+                return 0;
+            },
+            [&](const IdNode& id) {
+                out.push_back({PostfixOp::ID, std::int32_t(id.name_id)});
+                return 0;
+            },
+            [&](const NumNode& num) {
+                out.push_back({PostfixOp::NUM, num.num});
+                return 0;
+            },
+        });
+    }
+
+    NodePtr from_postfix(std::span<const PostfixItem> items) {
+        const std::size_t names = symbols().size();
+        std::vector<NodePtr> operands;
+        for (const PostfixItem& item: items) {
+            switch (item.opcode) {
+                case PostfixOp::NUM:
+                    operands.push_back(makeNum(item.operand));
+                    break;
+                case PostfixOp::ID:
+                    if (std::uint32_t(item.operand) >= names) return nullptr;
+                    operands.push_back(makeId(std::uint32_t(item.operand)));
+                    break;
+                case PostfixOp::BINOP: {
+                    if (operands.size() < 2 || item.operand < PLUS || item.operand > DIV) return nullptr;
+                    NodePtr right = std::move(operands.back());
+                    operands.pop_back();
+                    operands.back() = makeBinOp(operands.back(), Operator(item.operand), right);
+                    break;
+                }
+                default:
+                    return nullptr;
+            }
+        }
+
+        if (operands.size() != 1) return nullptr;
+        return operands.back();
+    }
+};
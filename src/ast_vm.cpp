@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "ast_vm.hpp"
+
+namespace AST {
+
+    // 32-bit arithmetic that wraps around instead of overflowing
+    static std::int32_t apply(Operator op, std::int32_t left, std::int32_t right) {
+        switch (op) {
+            case PLUS: return std::int32_t(std::uint32_t(left) + std::uint32_t(right));
+            case MINUS: return std::int32_t(std::uint32_t(left) - std::uint32_t(right));
+            case MUL: return std::int32_t(std::uint32_t(left) * std::uint32_t(right));
+            default: return right == -1 ? std::int32_t(0u - std::uint32_t(left)) : left / right;
+        }
+    }
+
+    std::uint32_t Program::slot(std::string_view name) const {
+        for (std::uint32_t i = 0; i < slot_names.size(); i++) {
+            if (slot_name(i) == name) return i;
+        }
+        return no_slot;
+    }
+
+    int compile(const NodePtr& root, Program& program) {
+        program.code.clear();
+        program.slot_names.clear();
+        program.max_stack = 0;
+
+        // where the value of a compiled subtree is: known constant or variable
+        // not pushed yet, or on top of the stack. NONE for null nodes
+        struct Operand {
+            enum Kind : std::uint8_t { NONE, CONST, VAR, STACK } kind = NONE;
+            std::int32_t value = 0;
+        };
+
+        std::unordered_map<std::uint32_t, std::uint32_t> slots; // name_id -> slot
+        std::size_t depth = 0;
+        bool bad_operator = false;
+        auto emit = [&](OpCode op, std::int32_t operand, int stack_change) {
+            program.code.push_back({op, operand});
+            depth += stack_change;
+            program.max_stack = std::max(program.max_stack, depth);
+        };
+        auto push = [&](Operand operand) {
+            if (operand.kind == Operand::CONST) emit(OpCode::PUSH_CONST, operand.value, 1);
+            else if (operand.kind == Operand::VAR) emit(OpCode::PUSH_VAR, operand.value, 1);
+        };
+        // opcodes of one kind are in Operator order
+        auto opcode = [](OpCode first, Operator op) { return OpCode(std::uint8_t(first) + op); };
+
+        // children are compiled before their parent, left first, so a subtree left
+        // on the stack by the right child lies above the one of the left child
+        Operand value = fold<Operand>(root, Overloaded{
+            [&](const IdNode& id) {
+                auto [it, added] = slots.try_emplace(id.name_id, program.slot_names.size());
+                if (added) program.slot_names.push_back(id.name_id);
+                return Operand{Operand::VAR, std::int32_t(it->second)};
+            },
+            [&](const NumNode& num) {
+                return Operand{Operand::CONST, num.num};
+            },
+            [&](const BinOpNode& binop, Operand left, Operand right) {
+                if (left.kind == Operand::NONE || right.kind == Operand::NONE) return Operand{};
+
+                Operator op = binop.op;
+                if (op < PLUS || op > DIV) {
+                    bad_operator = true;
+                    return Operand{};
+                }
+                if (left.kind == Operand::CONST && right.kind == Operand::CONST && !(op == DIV && right.value == 0)) {
+                    return Operand{Operand::CONST, apply(op, left.value, right.value)};
+                }
+
+                if (right.kind != Operand::STACK) {
+                    push(left);
+                    emit(opcode(right.kind == Operand::CONST ? OpCode::ADD_CONST : OpCode::ADD_VAR, op), right.value, 0);
+                } else if (left.kind == Operand::STACK) {
+                    emit(opcode(OpCode::ADD, op), 0, -1);
+                } else if (op == PLUS || op == MUL) {
+                    // right is on the stack, left is the immediate operand
+                    emit(opcode(left.kind == Operand::CONST ? OpCode::ADD_CONST : OpCode::ADD_VAR, op), left.value, 0);
+                } else {
+                    push(left);
+                    emit(op == MINUS ? OpCode::RSUB : OpCode::RDIV, 0, -1);
+                }
+                return Operand{Operand::STACK};
+            },
+        });
+
+        if (value.kind == Operand::NONE) {
+            program.code.clear();
+            program.slot_names.clear();
+            if (bad_operator) std::cerr << "Can't compile an expression tree with an unknown operator\n";
+            else std::cerr << "Can't compile an empty or incomplete expression tree\n";
+            return -1;
+        }
+        push(value);
+        emit(OpCode::RETURN, 0, 0);
+        return 0;
+    }
+
+
+    void Evaluator::report_division(const Program& program, const Instruction& div,
+                                    std::int32_t left, std::span<const std::int32_t> values) {
+        if (!error_stream) return;
+        std::ostream& os = *error_stream;
+        os << "Division by zero: " << left << " / ";
+        if (div.op == OpCode::DIV_VAR) {
+            std::string_view name = program.slot_name(div.operand);
+            os << name << ", " << name << " = " << values[div.operand];
+        } else {
+            os << "0";
+        }
+        os << "\n";
+    }
+
+    Evaluator::Status Evaluator::run(const Program& program, std::span<const std::int32_t> values,
+                                     std::int32_t& result) {
+        if (values.size() < program.slots()) {
+            if (error_stream) {
+                *error_stream << "Expression has " << program.slots() << " variables, "
+                              << values.size() << " values given\n";
+            }
+            return Status::BAD_BINDINGS;
+        }
+        if (stack.size() < program.max_stack) stack.resize(program.max_stack);
+
+        const std::int32_t *vars = values.data();
+        std::int32_t *top = stack.data(); // one past the top value
+        const Instruction *ip = program.code.data();
+
+        // with GNU C every handler jumps straight to the next one through the table,
+        // so each jump is predicted on its own, otherwise the switch is entered per instruction
+#if defined(__GNUC__)
+        static const void *const targets[] = {
+            &&op_PUSH_CONST, &&op_PUSH_VAR,
+            &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV,
+            &&op_RSUB, &&op_RDIV,
+            &&op_ADD_CONST, &&op_SUB_CONST, &&op_MUL_CONST, &&op_DIV_CONST,
+            &&op_ADD_VAR, &&op_SUB_VAR, &&op_MUL_VAR, &&op_DIV_VAR,
+            &&op_RETURN,
+        };
+#   define TARGET(name) case OpCode::name: op_##name:
+#   define DISPATCH() goto *targets[std::uint8_t((++ip)->op)]
+#else
+#   define TARGET(name) case OpCode::name:
+#   define DISPATCH() ++ip; continue
+#endif
+
+        for (;;) {
+            switch (ip->op) {
+                TARGET(PUSH_CONST) *top++ = ip->operand; DISPATCH();
+                TARGET(PUSH_VAR) *top++ = vars[ip->operand]; DISPATCH();
+
+                TARGET(ADD) --top; top[-1] = apply(PLUS, top[-1], top[0]); DISPATCH();
+                TARGET(SUB) --top; top[-1] = apply(MINUS, top[-1], top[0]); DISPATCH();
+                TARGET(MUL) --top; top[-1] = apply(MUL, top[-1], top[0]); DISPATCH();
+                TARGET(DIV)
+                    --top;
+                    if (top[0] == 0) {
+                        report_division(program, *ip, top[-1], values);
+                        return Status::DIV_BY_ZERO;
+                    }
+                    top[-1] = apply(DIV, top[-1], top[0]);
+                    DISPATCH();
+
+                TARGET(RSUB) --top; top[-1] = apply(MINUS, top[0], top[-1]); DISPATCH();
+                TARGET(RDIV)
+                    --top;
+                    if (top[-1] == 0) {
+                        report_division(program, *ip, top[0], values);
+                        return Status::DIV_BY_ZERO;
+                    }
+                    top[-1] = apply(DIV, top[0], top[-1]);
+                    DISPATCH();
+
+                TARGET(ADD_CONST) top[-1] = apply(PLUS, top[-1], ip->operand); DISPATCH();
+                TARGET(SUB_CONST) top[-1] = apply(MINUS, top[-1], ip->operand); DISPATCH();
+                TARGET(MUL_CONST) top[-1] = apply(MUL, top[-1], ip->operand); DISPATCH();
+                TARGET(DIV_CONST)
+                    if (ip->operand == 0) {
+                        report_division(program, *ip, top[-1], values);
+                        return Status::DIV_BY_ZERO;
+                    }
+                    top[-1] = apply(DIV, top[-1], ip->operand);
+                    DISPATCH();
+
+                TARGET(ADD_VAR) top[-1] = apply(PLUS, top[-1], vars[ip->operand]); DISPATCH();
+                TARGET(SUB_VAR) top[-1] = apply(MINUS, top[-1], vars[ip->operand]); DISPATCH();
+                TARGET(MUL_VAR) top[-1] = apply(MUL, top[-1], vars[ip->operand]); DISPATCH();
+                TARGET(DIV_VAR)
+                    if (vars[ip->operand] == 0) {
+                        report_division(program, *ip, top[-1], values);
+                        return Status::DIV_BY_ZERO;
+                    }
+                    top[-1] = apply(DIV, top[-1], vars[ip->operand]);
+                    DISPATCH();
+
+                TARGET(RETURN)
+                    result = top[-1];
+                    return Status::SUCCESS;
+            }
+        }
+#undef TARGET
+#undef DISPATCH
+    }
+};
@@ -0,0 +1,158 @@
+#include "ast_writer.hpp"
+
+namespace AST {
+
+    // fixed text of the dumps in ast.cpp, binary nodes indexed by Operator, '?' for others as label() does
+    static std::size_t op_index(Operator op) {
+        return unsigned(op) < 4 ? op : 4;
+    }
+
+    static constexpr std::string_view serialize_binop[] = {
+        "(BINOP:+", "(BINOP:-", "(BINOP:*", "(BINOP:/", "(BINOP:?",
+    };
+
+    static constexpr std::string_view graphviz_binop[] = {
+        " [label=\"+\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n",
+        " [label=\"-\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n",
+        " [label=\"*\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n",
+        " [label=\"/\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n",
+        " [label=\"?\", shape=rectangle, style=filled, fillcolor=\"#e1f5ff\"];\n",
+    };
+    static constexpr std::string_view graphviz_id_label = " [label=\"ID:";
+    static constexpr std::string_view graphviz_id_style = "\", shape=rectangle, style=filled, fillcolor=\"#f1e364\"];\n";
+    static constexpr std::string_view graphviz_num_label = " [label=\"NUM:";
+    static constexpr std::string_view graphviz_num_style = "\", shape=rectangle, style=filled, fillcolor=\"#38d878\"];\n";
+    static constexpr std::string_view graphviz_node = "  node";
+    static constexpr std::string_view graphviz_arrow = " -> node";
+    static constexpr std::string_view graphviz_left = " [label=\"left\"];\n";
+    static constexpr std::string_view graphviz_right = " [label=\"right\"];\n";
+
+    static constexpr std::string_view graphviz_header =
+        "digraph AST {\n"
+        "  rankdir=TB;\n"
+        "  node [fontname=\"Courier\", fontsize=10];\n"
+        "  edge [fontname=\"Courier\", fontsize=8];\n"
+        "\n";
+    static constexpr std::string_view graphviz_empty =
+        "digraph AST {\n"
+        "  label=\"Empty tree\";\n"
+        "}\n";
+    static constexpr std::string_view empty_tree = "<EMPTY_TREE>";
+
+    std::string_view TextWriter::name(std::uint32_t name_id) {
+        if (name_id >= names.size()) names.resize(name_id + 1);
+        if (names[name_id].empty()) names[name_id] = symbols().name(name_id);
+        return names[name_id];
+    }
+
+    void TextWriter::flush() {
+        if (!sink || used == 0) return;
+        sink->write(buffer.data(), used);
+        used = 0;
+    }
+
+    void TextWriter::binop(std::size_t id, Operator op, DumpType type) {
+        if (type == SERIALIZE) {
+            put(serialize_binop[op_index(op)]);
+            return;
+        }
+        put(graphviz_node);
+        put_number(id);
+        put(graphviz_binop[op_index(op)]);
+    }
+
+    // value is NUM value or ID name_id
+    void TextWriter::leaf(std::size_t id, NodeKind kind, std::int32_t value, DumpType type) {
+        if (type == SERIALIZE) {
+            if (kind == NodeKind::ID) {
+                put("(ID:");
+                put(name(value));
+            } else {
+                put("(NUM:");
+                put_number(value);
+            }
+            put(")");
+            return;
+        }
+        put(graphviz_node);
+        put_number(id);
+        if (kind == NodeKind::ID) {
+            put(graphviz_id_label);
+            put(name(value));
+            put(graphviz_id_style);
+        } else {
+            put(graphviz_num_label);
+            put_number(value);
+            put(graphviz_num_style);
+        }
+    }
+
+    void TextWriter::edge(std::size_t from, std::size_t to, Side side) {
+        put(graphviz_node);
+        put_number(from);
+        put(graphviz_arrow);
+        put_number(to);
+        put(side == Side::LEFT ? graphviz_left : graphviz_right);
+    }
+
+    void TextWriter::open_graph() {
+        put(graphviz_header);
+    }
+
+    void TextWriter::close_graph() {
+        put("}\n");
+    }
+
+    void TextWriter::write(const NodePtr& root, DumpType type) {
+        if (!root) {
+            append(type == SERIALIZE ? empty_tree : graphviz_empty);
+            return;
+        }
+
+        if (type == GRAPHVIZ) open_graph();
+        walk(root,
+            [&](const Node& node) {
+                visit(Overloaded{
+                    [&](const BinOpNode& n) { binop(n.id, n.op, type); },
+                    [&](const IdNode& n) { leaf(n.id, NodeKind::ID, n.name_id, type); },
+                    [&](const NumNode& n) { leaf(n.id, NodeKind::NUM, n.num, type); },
+                }, node);
+            },
+            [&](const BinOpNode& n, Side side) {
+                if (type == SERIALIZE) {
+                    if (side == Side::RIGHT) put(")");
+                    return;
+                }
+                const NodePtr& child = side == Side::LEFT ? n.left : n.right;
+                if (child) edge(n.id, child->id, side);
+            });
+        if (type == GRAPHVIZ) close_graph();
+        maybe_flush();
+    }
+
+    void TextWriter::write(const Tree& tree, DumpType type) {
+        if (tree.empty()) {
+            append(type == SERIALIZE ? empty_tree : graphviz_empty);
+            return;
+        }
+
+        if (type == GRAPHVIZ) open_graph();
+        walk(tree, tree.root,
+            [&](NodeIndex i) {
+                const TreeNode& n = tree[i];
+                if (n.kind == NodeKind::BINOP) binop(n.id, n.op, type);
+                else leaf(n.id, n.kind, n.value, type);
+            },
+            [&](NodeIndex i, Side side) {
+                if (type == SERIALIZE) {
+                    if (side == Side::RIGHT) put(")");
+                    return;
+                }
+                const TreeNode& n = tree[i];
+                NodeIndex child = side == Side::LEFT ? n.left : n.right;
+                if (child != no_node) edge(n.id, tree[child].id, side);
+            });
+        if (type == GRAPHVIZ) close_graph();
+        maybe_flush();
+    }
+};
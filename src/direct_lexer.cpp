@@ -0,0 +1,209 @@
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "direct_lexer.hpp"
+
+namespace {
+    enum CharClass : std::uint8_t { OTHER = 0, DIGIT, ALPHA, OPERATOR, BLANK, NEWLINE };
+
+    // same classes as the rules of lexer.ll, other operators come from the symbol map
+    constexpr std::array<CharClass, 256> char_class = [] {
+        std::array<CharClass, 256> table{};
+        for (int c = '0'; c <= '9'; c++) table[c] = DIGIT;
+        for (int c = 'a'; c <= 'z'; c++) table[c] = ALPHA;
+        for (int c = 'A'; c <= 'Z'; c++) table[c] = ALPHA;
+        for (char c: {'-', '+', '*', '/', '(', ')'}) table[static_cast<unsigned char>(c)] = OPERATOR;
+        table[' '] = BLANK;
+        table['\t'] = BLANK;
+        table['\n'] = NEWLINE;
+        return table;
+    }();
+
+    inline CharClass classify(char c) {
+        return char_class[static_cast<unsigned char>(c)];
+    }
+
+    // characters the table leaves OTHER are operators if the grammar has them as terminals
+    inline CharClass classify(char c, const SymbolMap& symbols) {
+        CharClass cls = classify(c);
+        if (cls == OTHER && symbols.operators[static_cast<unsigned char>(c)] != 0) return OPERATOR;
+        return cls;
+    }
+
+#if defined(__SSE2__)
+    // bit i is set if lo <= bytes[i] <= hi (unsigned)
+    inline unsigned range_mask(__m128i bytes, char lo, char hi) {
+        __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8(lo));
+        __m128i clamped = _mm_min_epu8(shifted, _mm_set1_epi8(char(hi - lo)));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(clamped, shifted));
+    }
+
+    template <CharClass cls>
+    inline unsigned class_mask(__m128i bytes) {
+        if constexpr (cls == DIGIT) {
+            return range_mask(bytes, '0', '9');
+        } else if constexpr (cls == ALPHA) {
+            // setting bit 5 maps upper case letters to lower case and nothing else into a-z
+            return range_mask(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+        } else {
+            static_assert(cls == BLANK);
+            return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))));
+        }
+    }
+#endif
+
+    /// @brief Position of the first character at or after pos outside of cls
+    template <CharClass cls>
+    std::size_t run_end(std::string_view text, std::size_t pos) {
+#if defined(__SSE2__)
+        while (pos + 16 <= text.size()) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+            unsigned mask = class_mask<cls>(bytes);
+            if (mask != 0xFFFF) return pos + std::countr_one(mask);
+            pos += 16;
+        }
+#endif
+        while (pos < text.size() && classify(text[pos]) == cls) pos++;
+        return pos;
+    }
+};
+
+const Token& DirectLexer::next_tok() {
+    // skipping blanks and newlines
+    while (pos < text.size()) {
+        CharClass cls = classify(text[pos]);
+        if (cls == BLANK) {
+            pos = run_end<BLANK>(text, pos);
+        } else if (cls == NEWLINE) {
+            line++;
+            line_start = ++pos;
+        } else {
+            break;
+        }
+    }
+
+    int col = pos - line_start;
+    if (pos == text.size()) {
+        current_tok = Token{TokenType::END, "", std::uint32_t(pos), line, col};
+        current_tok.symbol_ = symbols->end;
+        return current_tok;
+    }
+
+    std::size_t start = pos;
+    switch (classify(text[pos], *symbols)) {
+        case DIGIT:
+            pos = run_end<DIGIT>(text, pos);
+            current_tok = Token{TokenType::NUMBER, text.substr(start, pos - start), std::uint32_t(start), line, col};
+            current_tok.symbol_ = current_tok.out_of_range ? SymbolMap::error_symbol : symbols->number;
+            break;
+        case ALPHA:
+            pos = run_end<ALPHA>(text, pos);
+            current_tok = Token{TokenType::IDENTIFIER, text.substr(start, pos - start), std::uint32_t(start), line, col};
+            current_tok.symbol_ = symbols->word(text.substr(start, pos - start));
+            break;
+        case OPERATOR:
+            current_tok = Token{TokenType::OPERATOR, text.substr(pos++, 1), std::uint32_t(start), line, col};
+            current_tok.symbol_ = symbols->operators[static_cast<unsigned char>(text[start])];
+            break;
+        default:
+            current_tok = Token{TokenType::UNKNOWN, text.substr(pos++, 1), std::uint32_t(start), line, col};
+            current_tok.symbol_ = SymbolMap::error_symbol;
+            break;
+    }
+    return current_tok;
+}
+
+void PushLexer::end_run() {
+    std::string_view lexeme = std::string_view(lexemes).substr(run_offset);
+    current_tok = Token{run, lexeme, run_offset, run_line, run_col};
+    if (run == TokenType::IDENTIFIER) current_tok.symbol_ = symbols->word(lexeme);
+    else current_tok.symbol_ = current_tok.out_of_range ? SymbolMap::error_symbol : symbols->number;
+    run = TokenType::END;
+}
+
+void PushLexer::stop_too_long() {
+    current_tok = Token{TokenType::UNKNOWN, "", std::uint32_t(lexemes.size()), line, col};
+    current_tok.too_long = true;
+    current_tok.symbol_ = SymbolMap::error_symbol;
+    run = TokenType::END;
+}
+
+bool PushLexer::next_tok() {
+    while (pos < chunk.size()) {
+        CharClass cls = classify(chunk[pos], *symbols);
+
+        // continuing the run, it may go on in the next chunk
+        if (run != TokenType::END) {
+            CharClass run_class = run == TokenType::NUMBER ? DIGIT : ALPHA;
+            if (cls != run_class) {
+                end_run();
+                return true;
+            }
+
+            std::size_t end = run == TokenType::NUMBER ? run_end<DIGIT>(chunk, pos) : run_end<ALPHA>(chunk, pos);
+            if (lexemes.size() + (end - pos) > source_limit) {
+                stop_too_long();
+                return true;
+            }
+            lexemes += chunk.substr(pos, end - pos);
+            col += end - pos;
+            pos = end;
+            continue;
+        }
+
+        switch (cls) {
+            case BLANK: {
+                std::size_t end = run_end<BLANK>(chunk, pos);
+                col += end - pos;
+                pos = end;
+                break;
+            }
+            case NEWLINE:
+                line++;
+                col = 0;
+                pos++;
+                break;
+            case DIGIT:
+            case ALPHA:
+                run = cls == DIGIT ? TokenType::NUMBER : TokenType::IDENTIFIER;
+                run_offset = lexemes.size();
+                run_line = line;
+                run_col = col;
+                break;
+            default: {
+                if (lexemes.size() + 1 > source_limit) {
+                    stop_too_long();
+                    return true;
+                }
+                std::uint32_t offset = lexemes.size();
+                lexemes += chunk[pos];
+                if (cls == OPERATOR) {
+                    current_tok = Token{TokenType::OPERATOR, std::string_view(lexemes).substr(offset), offset, line, col};
+                    current_tok.symbol_ = symbols->operators[static_cast<unsigned char>(chunk[pos])];
+                } else {
+                    current_tok = Token{TokenType::UNKNOWN, std::string_view(lexemes).substr(offset), offset, line, col};
+                    current_tok.symbol_ = SymbolMap::error_symbol;
+                }
+                pos++;
+                col++;
+                return true;
+            }
+        }
+    }
+
+    if (!input_end) return false;
+
+    if (run != TokenType::END) {
+        end_run();
+    } else {
+        current_tok = Token{TokenType::END, "", std::uint32_t(lexemes.size()), line, col};
+        current_tok.symbol_ = symbols->end;
+    }
+    return true;
+}
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <sstream>
+
+#include "syntax_analyzer.hpp"
+
+using Grammar = ParseTables::Grammar;
+using Symbol = ParseTables::Symbol;
+
+Grammar Grammar::builtin() {
+    Grammar g;
+    for (int s = 0; s < builtinSymbols; s++) {
+        std::ostringstream name;
+        name << Symbol(s);
+        g.names.push_back(name.str());
+        g.is_term.push_back(isBuiltinTerm(Symbol(s)));
+    }
+
+    for (const ProductionSpec& spec: builtin_grammar) {
+        g.productions.push_back({spec.lhs,
+                                 {spec.rhs.begin(), spec.rhs.begin() + spec.rhs_len()},
+                                 std::string(spec.action)});
+    }
+
+    g.start_symbol = E0;
+    g.end_symbol = END;
+    g.tokens.end = END;
+    g.tokens.number = NUM;
+    g.tokens.identifier = ID;
+    for (Symbol s: {PLUS, MINUS, MUL, DIV, LBRACKET, RBRACKET}) {
+        g.tokens.operators[static_cast<unsigned char>(g.names[s][0])] = s;
+    }
+
+    return g;
+}
+
+Symbol Grammar::add_symbol(const std::string& name) {
+    auto [it, inserted] = symbol_ids.try_emplace(name, Symbol(names.size()));
+    if (inserted) {
+        names.push_back(name);
+        is_term.push_back(false);
+    }
+    return it->second;
+}
+
+/* ==================== BNF READER ====================================== */
+namespace {
+    struct BnfToken {
+        enum Kind { NAME, LITERAL, ARROW, BAR, SEMI, ACTION, EMPTY, END, BAD } kind;
+        std::string text;
+        int line;
+    };
+
+    class BnfLexer {
+        std::istream& in;
+        int line = 1;
+
+    public:
+        explicit BnfLexer(std::istream& in): in(in) {}
+
+        BnfToken next() {
+            int c = in.get();
+            while (c != EOF) {
+                if (c == '\n') line++;
+                if (c == '#') {
+                    while (c != EOF && c != '\n') c = in.get();
+                    continue;
+                }
+                if (!std::isspace(c)) break;
+                c = in.get();
+            }
+
+            if (c == EOF) return {BnfToken::END, "", line};
+            if (c == '|') return {BnfToken::BAR, "|", line};
+            if (c == ';') return {BnfToken::SEMI, ";", line};
+            if (c == '-' && in.peek() == '>') {
+                in.get();
+                return {BnfToken::ARROW, "->", line};
+            }
+            if (c == '\'' || c == '"') {
+                std::string text;
+                for (int q = in.get(); q != c; q = in.get()) {
+                    if (q == EOF || q == '\n') return {BnfToken::BAD, "unterminated literal", line};
+                    text += char(q);
+                }
+                return {BnfToken::LITERAL, text, line};
+            }
+            if (c == '@' || c == '%' || std::isalpha(c) || c == '_') {
+                std::string text;
+                while (std::isalnum(in.peek()) || in.peek() == '_') text += char(in.get());
+
+                if (c == '@') return {text.empty() ? BnfToken::BAD : BnfToken::ACTION, text, line};
+                if (c == '%') {
+                    if (text == "empty") return {BnfToken::EMPTY, "%empty", line};
+                    return {BnfToken::BAD, "%" + text, line};
+                }
+                return {BnfToken::NAME, char(c) + text, line};
+            }
+
+            return {BnfToken::BAD, std::string(1, char(c)), line};
+        }
+    };
+
+    struct RawSymbol {
+        std::string text;
+        bool quoted;
+    };
+
+    struct RawProduction {
+        std::string lhs;
+        std::vector<RawSymbol> rhs;
+        std::string action;
+        int line;
+    };
+
+    // lexers read identifiers as runs of letters, so keywords can't have other characters
+    bool is_keyword(const std::string& text) {
+        if (text.empty()) return false;
+        for (char c: text)
+            if (!std::isalpha(static_cast<unsigned char>(c))) return false;
+        return true;
+    }
+
+    // digits, letters and blanks are never operator tokens
+    bool is_operator(const std::string& text) {
+        return text.size() == 1 && std::ispunct(static_cast<unsigned char>(text[0]));
+    }
+};
+
+int Grammar::load(std::istream& in) {
+    BnfLexer lexer(in);
+    std::vector<RawProduction> raw;
+    std::vector<std::string> lhs_order;
+
+    auto error = [](const BnfToken& tok, const std::string& msg) {
+        std::cerr << "Grammar error at line " << tok.line << ": " << msg;
+        if (!tok.text.empty()) std::cerr << " (got '" << tok.text << "')";
+        std::cerr << "\n";
+        return -1;
+    };
+
+    /* ---------- reading rules ---------- */
+    BnfToken tok = lexer.next();
+    while (tok.kind != BnfToken::END) {
+        if (tok.kind != BnfToken::NAME) return error(tok, "expected nonterminal name");
+        std::string lhs = tok.text;
+        lhs_order.push_back(lhs);
+
+        tok = lexer.next();
+        if (tok.kind != BnfToken::ARROW) return error(tok, "expected '->'");
+
+        RawProduction prod{lhs, {}, "", tok.line};
+        bool empty_marker = false;
+        while (true) {
+            tok = lexer.next();
+            switch (tok.kind) {
+                case BnfToken::NAME:
+                case BnfToken::LITERAL:
+                    if (empty_marker || !prod.action.empty())
+                        return error(tok, "symbol after '%empty' or action");
+                    if (tok.kind == BnfToken::LITERAL && tok.text.empty())
+                        return error(tok, "empty literal");
+                    prod.rhs.push_back({tok.text, tok.kind == BnfToken::LITERAL});
+                    continue;
+                case BnfToken::EMPTY:
+                    if (!prod.rhs.empty() || empty_marker) return error(tok, "'%empty' must be alone");
+                    empty_marker = true;
+                    continue;
+                case BnfToken::ACTION:
+                    if (!prod.action.empty()) return error(tok, "second action for alternative");
+                    prod.action = tok.text;
+                    continue;
+                case BnfToken::BAR:
+                case BnfToken::SEMI:
+                    if (prod.rhs.empty() && !empty_marker)
+                        return error(tok, "empty alternative, use '%empty'");
+                    raw.push_back(prod);
+                    prod = {lhs, {}, "", tok.line};
+                    empty_marker = false;
+                    break;
+                default:
+                    return error(tok, "unexpected token in rule");
+            }
+            if (tok.kind == BnfToken::SEMI) break;
+        }
+
+        tok = lexer.next();
+    }
+
+    if (raw.empty()) {
+        std::cerr << "Grammar error: no rules\n";
+        return -1;
+    }
+
+    /* ---------- numbering symbols ---------- */
+    // EPS, augmented start, nonterminals, terminals, END
+    *this = Grammar{};
+    add_symbol("$");
+
+    std::string start_name = lhs_order.front() + "'";
+    while (std::find(lhs_order.begin(), lhs_order.end(), start_name) != lhs_order.end())
+        start_name += "'";
+    start_symbol = add_symbol(start_name);
+
+    for (const std::string& lhs: lhs_order) add_symbol(lhs);
+
+    // quoted symbols are keyed with quotes, so 'id' differs from id
+    auto key = [](const RawSymbol& sym) {
+        return sym.quoted ? "'" + sym.text + "'" : sym.text;
+    };
+
+    for (const RawProduction& prod: raw) {
+        for (const RawSymbol& sym: prod.rhs) {
+            if (!sym.quoted && symbol_ids.contains(sym.text)) continue;
+
+            std::size_t prev_count = names.size();
+            Symbol s = add_symbol(key(sym));
+            if (names.size() == prev_count) continue;
+
+            // new terminal
+            names[s] = sym.text;
+            is_term[s] = true;
+
+            if (!sym.quoted) {
+                if (sym.text == "num") tokens.number = s;
+                else if (sym.text == "id") tokens.identifier = s;
+                else {
+                    std::cerr << "Grammar error at line " << prod.line << ": '" << sym.text
+                              << "' has no rules and is not a token class (num, id)\n";
+                    return -1;
+                }
+            } else if (is_keyword(sym.text)) {
+                tokens.keywords[sym.text] = s;
+            } else if (is_operator(sym.text)) {
+                tokens.operators[static_cast<unsigned char>(sym.text[0])] = s;
+            } else {
+                std::cerr << "Grammar error at line " << prod.line << ": literal '" << sym.text
+                          << "' must be a single punctuation character or a keyword of letters\n";
+                return -1;
+            }
+        }
+    }
+
+    end_symbol = add_symbol("$END");
+    names[end_symbol] = "$";
+    is_term[end_symbol] = true;
+    tokens.end = end_symbol;
+
+    /* ---------- productions ---------- */
+    productions.push_back({start_symbol, {symbol_ids[lhs_order.front()]}, ""});
+    for (const RawProduction& prod: raw) {
+        Production p{symbol_ids[prod.lhs], {}, prod.action};
+        for (const RawSymbol& sym: prod.rhs) {
+            p.rhs.push_back(symbol_ids[key(sym)]);
+        }
+        productions.push_back(std::move(p));
+    }
+
+    return 0;
+}
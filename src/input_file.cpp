@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "input_file.hpp"
+
+namespace SLR {
+
+    // @brief read() that retries on interrupts, -1 on error
+    static long read_some(int fd, char *dest, std::size_t size) {
+        while (true) {
+            long n = ::read(fd, dest, size);
+            if (n >= 0 || errno != EINTR) return n;
+        }
+    }
+
+    static int open_input(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) std::cerr << "Failed to open file '" << path << "'\n";
+        return fd;
+    }
+
+    InputFile::~InputFile() {
+        if (mapped_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    bool InputFile::map(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return false;
+
+        void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) return false;
+        // input is scanned once from start to end
+        madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+        data_ = static_cast<const char*>(mapped);
+        size_ = st.st_size;
+        mapped_ = true;
+        return true;
+    }
+
+    int InputFile::open(const std::string& path) {
+        int fd = open_input(path);
+        if (fd < 0) return -1;
+
+        if (!map(fd)) {
+            buffer.clear();
+            long n;
+            do {
+                std::size_t old_size = buffer.size();
+                buffer.resize(old_size + input_block_size);
+                n = read_some(fd, buffer.data() + old_size, input_block_size);
+                buffer.resize(old_size + std::max(n, 0L));
+            } while (n > 0);
+
+            if (n < 0) {
+                std::cerr << "Failed to read file '" << path << "'\n";
+                close(fd);
+                return -1;
+            }
+            data_ = buffer.data();
+            size_ = buffer.size();
+        }
+
+        close(fd);
+        return 0;
+    }
+
+    void InputFile::release(std::size_t offset) {
+        if (!mapped_) return;
+
+        std::size_t page = sysconf(_SC_PAGESIZE);
+        std::size_t released_end = std::min(offset, size_) / page * page;
+        if (released_end > released) {
+            madvise(const_cast<char*>(data_) + released, released_end - released, MADV_DONTNEED);
+            released = released_end;
+        }
+    }
+
+
+    LineBlockReader::~LineBlockReader() {
+        if (fd >= 0) close(fd);
+    }
+
+    int LineBlockReader::open(const std::string& path, std::size_t window_size) {
+        fd = open_input(path);
+        if (fd < 0) return -1;
+
+        window = std::max<std::size_t>(window_size, 1);
+        if (file.map(fd)) {
+            close(fd);
+            fd = -1;
+        } else {
+            buffer.resize(window);
+        }
+        return 0;
+    }
+
+    bool LineBlockReader::fill(std::string_view& avail) {
+        if (file.is_mapped()) {
+            avail = file.view().substr(pos, window);
+            return true;
+        }
+
+        // moving the unread tail to the front and reading up to the full window
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+        while (!eof && end < window) {
+            long n = read_some(fd, buffer.data() + end, window - end);
+            if (n < 0) return false;
+            if (n == 0) eof = true;
+            end += n;
+        }
+
+        avail = {buffer.data(), end};
+        return true;
+    }
+
+    void LineBlockReader::consume(std::size_t n) {
+        if (file.is_mapped()) {
+            pos += n;
+        } else {
+            begin += n;
+        }
+    }
+
+    LineBlockReader::Status LineBlockReader::next(std::string_view& block) {
+        // previous block is no longer used
+        file.release(pos);
+
+        std::string_view avail;
+        if (!fill(avail)) return Status::READ_ERR;
+        if (avail.empty()) return Status::END;
+
+        bool last = file.is_mapped() ? pos + avail.size() == file.view().size() : eof;
+        std::size_t line_end = avail.rfind('\n');
+        if (last || line_end != std::string_view::npos) {
+            block = last ? avail : avail.substr(0, line_end + 1);
+            consume(block.size());
+            return Status::LINES;
+        }
+
+        // window is full and has no '\n': skipping the rest of the line
+        while (true) {
+            consume(avail.size());
+            file.release(pos);
+            if (!fill(avail)) return Status::READ_ERR;
+            if (avail.empty()) return Status::TOO_LONG;
+
+            line_end = avail.find('\n');
+            if (line_end != std::string_view::npos) {
+                consume(line_end + 1);
+                return Status::TOO_LONG;
+            }
+        }
+    }
+};
@@ -9,13 +9,20 @@
 
 #include "lexer.hpp"
 #include "AST.hpp"
+#include "ast_writer.hpp"
 #include "syntax_analyzer.hpp"
+#include "parallel_parser.hpp"
 
 struct CLIOptions {
     bool show_help = false;
     bool export_table = false;
     std::string table_file;
+    std::string tables_bin; // prebuilt binary tables
+    std::string grammar_file;
+    bool lalr = false;
+    bool compressed = false;
     std::string input_file;
+    unsigned jobs = 0; // hardware concurrency
     std::string input_string;
     std::string dot_file;
     std::string svg_file;
@@ -40,6 +47,24 @@ CLIOptions parse_args(int argc, char* argv[]) {
             opts.table_file = argv[++i];
             opts.interactive = false;
         }
+        else if (arg == "-g" || arg == "--grammar") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Error: -g/--grammar requires a filename argument");
+            }
+            opts.grammar_file = argv[++i];
+        }
+        else if (arg == "--lalr") {
+            opts.lalr = true;
+        }
+        else if (arg == "--compressed") {
+            opts.compressed = true;
+        }
+        else if (arg == "--tables") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Error: --tables requires a filename argument");
+            }
+            opts.tables_bin = argv[++i];
+        }
         else if (arg == "-f" || arg == "--file") {
             if (i + 1 >= argc) {
                 throw std::runtime_error("Error: -f/--file requires a filename argument");
@@ -47,6 +72,16 @@ CLIOptions parse_args(int argc, char* argv[]) {
             opts.input_file = argv[++i];
             opts.interactive = false;
         }
+        else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Error: -j/--jobs requires a number argument");
+            }
+            int jobs = std::atoi(argv[++i]);
+            if (jobs <= 0) {
+                throw std::runtime_error("Error: -j/--jobs requires a positive number");
+            }
+            opts.jobs = jobs;
+        }
         else if (arg == "-s" || arg == "--string") {
             if (i + 1 >= argc) {
                 throw std::runtime_error("Error: -s/--string requires an expression argument");
@@ -71,6 +106,11 @@ CLIOptions parse_args(int argc, char* argv[]) {
         }
     }
 
+    // lines of a file are parsed on several threads into text, there is no single tree or log
+    if (!opts.input_file.empty() && (!opts.dot_file.empty() || !opts.svg_file.empty())) {
+        throw std::runtime_error("Error: --dot and --svg save the tree of one expression, they can't be used with -f");
+    }
+
     return opts;
 }
 
@@ -81,15 +121,22 @@ Usage: parser [OPTIONS]
 
 Options:
   -h, --help                Show this help message and exit
-  -f FILE, --file FILE      Parse expressions from FILE (one per line)
+  -f FILE, --file FILE      Parse expressions from FILE (one per line) in parallel,
+                            without parse_log.csv; can't be combined with --dot/--svg
+  -j N, --jobs N            Threads for -f (default: number of cores)
   -s EXPR, --string EXPR    Parse single expression EXPR
   --export-table FILE       Export SLR action/goto tables to CSV FILE
+  --tables FILE             Parse with binary tables from FILE (built by slr-tablegen)
+  -g FILE, --grammar FILE   Use grammar from BNF FILE instead of the built-in one
+  --lalr                    Build LALR(1) tables instead of SLR(1)
+  --compressed              Parse with compressed tables (default reductions, comb vectors)
   --dot FILE                Save AST to Graphviz DOT FILE after parsing
   --svg FILE                Save AST to SVG FILE (requires 'dot' utility)
 
 Examples:
   parser -s "2 + 3 * 4"                # Parse single expression
   parser -f expressions.txt            # Parse multiple expressions from file
+  parser -f expressions.txt -j 4       # Same on 4 threads
   parser --export-table tables.csv     # Export parser tables
   parser -s "a + b" --dot ast.dot      # Parse and save AST to DOT
   parser -s "1+2*3" --svg tree.svg     # Parse and generate SVG directly
@@ -115,6 +162,18 @@ bool parse_expression(SyntaxAnalyzer& parser, const std::string& expr) {
     }
 }
 
+const char *status_name(SyntaxAnalyzer::ParseStatus status) {
+    switch (status) {
+        case SyntaxAnalyzer::ParseStatus::SUCCESS: return "success";
+        case SyntaxAnalyzer::ParseStatus::BAD_INPUT: return "bad input";
+        case SyntaxAnalyzer::ParseStatus::LEXICAL_ERR: return "lexical error";
+        case SyntaxAnalyzer::ParseStatus::SYNTAX_ERR: return "syntax error";
+        case SyntaxAnalyzer::ParseStatus::FATAL_ERR: return "fatal error";
+        case SyntaxAnalyzer::ParseStatus::INCOMPLETE: return "incomplete";
+        default: return "unknown status";
+    }
+}
+
 // Сохранение AST в формате Graphviz
 bool save_ast_dot(const AST::NodePtr& root, const std::string& filename) {
     try {
@@ -123,7 +182,7 @@ bool save_ast_dot(const AST::NodePtr& root, const std::string& filename) {
             std::cerr << "Error: Cannot open file '" << filename << "' for writing\n";
             return false;
         }
-        AST::dumpTreeAsGraphviz(root, file);
+        AST::TextWriter(&file).write(root, AST::GRAPHVIZ);
         std::cout << "AST saved to: " << filename << "\n";
         return true;
     } catch (const std::exception& e) {
@@ -168,24 +227,50 @@ int main(int argc, char* argv[]) {
 
         // Initialization
         SyntaxAnalyzer parser;
-        int init_error = parser.init();
+        // table export needs canonic states and FIRST/FOLLOW sets,
+        // so tables are rebuilt instead of using precomputed ones
+        if (!opts.grammar_file.empty() && parser.load_grammar(opts.grammar_file)) {
+            return EXIT_FAILURE;
+        }
+
+        int init_error = 0;
+        if (!opts.tables_bin.empty() && !opts.export_table) {
+            init_error = parser.init_from_file(opts.tables_bin);
+        } else {
+            bool runtime = opts.export_table || opts.lalr || !opts.grammar_file.empty();
+            init_error = parser.init(runtime ? SyntaxAnalyzer::TableSource::RUNTIME
+                                             : SyntaxAnalyzer::TableSource::COMPILED,
+                                     opts.lalr ? SyntaxAnalyzer::Lookahead::LALR
+                                               : SyntaxAnalyzer::Lookahead::SLR);
+        }
+        if (init_error > 0) {
+            const auto& stats = parser.table_stats();
+            std::cerr << "Grammar has " << stats.conflicts() << " conflicts in " << stats.states << " states ("
+                      << stats.shift_reduce << " shift/reduce, " << stats.reduce_reduce << " reduce/reduce)\n";
+        }
+        if (!init_error && opts.compressed) {
+            init_error = parser.set_table_layout(SyntaxAnalyzer::TableLayout::COMPRESSED);
+        }
         if (init_error) {
             std::cerr << "Parser initialization error (code: " << init_error << ")\n";
             return EXIT_FAILURE;
         }
 
-        // Log stream init
-        std::ofstream parse_log("parse_log.csv");
-        if (!parse_log.is_open()) {
-            std::cerr << "Failed to open file for parsing log\n";
-        } else {
-            parser.set_log_stream(parse_log);
+        // Log stream init, parsing a file writes no log
+        std::ofstream parse_log;
+        if (opts.input_file.empty()) {
+            parse_log.open("parse_log.csv");
+            if (!parse_log.is_open()) {
+                std::cerr << "Failed to open file for parsing log\n";
+            } else {
+                parser.set_log_stream(parse_log);
+            }
         }
 
 
         // Export first, follow and action/goto tables
         if (opts.export_table) {
-            std::cout << "Exporting SLR tables to: " << opts.table_file << "\n";
+            std::cout << "Exporting " << (opts.lalr ? "LALR" : "SLR") << " tables to: " << opts.table_file << "\n";
             parser.dump_tables(opts.table_file);
             return EXIT_SUCCESS;
         }
@@ -198,7 +283,29 @@ int main(int argc, char* argv[]) {
         }
         // Parse from file
         else if (!opts.input_file.empty()) {
-            if (parser.parse_file(opts.input_file) != SyntaxAnalyzer::ParseStatus::SUCCESS) {
+            // lines come in input order, failed lines are reported by number
+            bool all_parsed = true;
+            // results go to stdout in large blocks, not line by line
+            AST::TextWriter out(&std::cout);
+            auto print_line = [&](std::size_t line, SyntaxAnalyzer::ParseStatus status, const std::string& tree) {
+                if (status == SyntaxAnalyzer::ParseStatus::SUCCESS) {
+                    out.append(tree);
+                } else {
+                    out.append("Line ");
+                    out.append_number(line);
+                    out.append(": ");
+                    out.append(status_name(status));
+                    all_parsed = false;
+                }
+                out.append('\n');
+            };
+            // file is read in bounded windows, so its size is not limited by memory
+            int read_error = stream_file_lines(parser, opts.input_file, print_line, default_line_window, opts.jobs);
+            out.flush();
+            if (read_error) {
+                return EXIT_FAILURE;
+            }
+            if (!all_parsed) {
                 return EXIT_FAILURE;
             }
         }
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ast_writer.hpp"
+#include "input_file.hpp"
+#include "parallel_parser.hpp"
+#include "work_stealing.hpp"
+
+// lines per task: big enough to amortize stealing, small enough to balance the tail
+static constexpr std::size_t chunk_lines = 1024;
+// text per pipelined block, unless it is one longer line. Token offsets are 32-bit
+// from the start of the block, so a block never spans more than UINT32_MAX bytes
+static constexpr std::size_t chunk_bytes = std::size_t(1) << 20;
+
+static std::vector<std::string_view> split_lines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+
+        std::string_view line = text.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        lines.push_back(line);
+
+        pos = end + 1;
+    }
+    return lines;
+}
+
+LineResults parse_lines(const ParseTables& tables, std::string_view text, unsigned n_threads) {
+    if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::string_view> lines = split_lines(text);
+
+    LineResults results;
+    results.status.resize(lines.size());
+    results.serialized.resize(lines.size());
+
+    std::size_t n_chunks = (lines.size() + chunk_lines - 1) / chunk_lines;
+    n_threads = std::min<std::size_t>(n_threads, std::max<std::size_t>(n_chunks, 1));
+
+    // parsers are created lazily by their worker threads
+    std::vector<std::unique_ptr<Parser>> parsers(n_threads);
+    std::vector<std::unique_ptr<AST::TextWriter>> outputs(n_threads);
+
+    SLR::run_work_stealing(n_chunks, n_threads, [&](std::size_t chunk, unsigned worker) {
+        if (!parsers[worker]) {
+            parsers[worker] = std::make_unique<Parser>(tables);
+            parsers[worker]->set_error_stream(nullptr);
+            parsers[worker]->set_ast_storage(Parser::AstStorage::ARENA);
+            outputs[worker] = std::make_unique<AST::TextWriter>();
+        }
+        Parser& parser = *parsers[worker];
+        AST::TextWriter& out = *outputs[worker];
+
+        std::size_t end = std::min(lines.size(), (chunk + 1) * chunk_lines);
+        for (std::size_t i = chunk * chunk_lines; i < end; i++) {
+            // slots are disjoint between chunks, so no synchronization is needed
+            results.status[i] = parser.parse_view(lines[i]);
+
+            out.clear();
+            out.write(parser.get_tree(), AST::SERIALIZE);
+            results.serialized[i] = out.view();
+        }
+    });
+
+    return results;
+}
+
+namespace {
+    // @brief Tokens of lines [first, first + count) of parse_lines_pipelined
+    struct TokenBlock {
+        TokenBuffer tokens;
+        std::size_t first = 0;
+        std::size_t count = 0;
+        bool too_long = false; // the block is one line over UINT32_MAX bytes, not tokenized
+    };
+
+    // @brief Blocks passed from the tokenizing thread to the parsing one and back.
+    // There are only a few blocks, so the tokenizer waits when it gets too far ahead
+    class BlockQueue {
+        std::deque<TokenBlock*> blocks;
+        std::mutex mutex;
+        std::condition_variable ready;
+
+    public:
+        void push(TokenBlock *block) {
+            {
+                std::lock_guard lock(mutex);
+                blocks.push_back(block);
+            }
+            ready.notify_one();
+        }
+
+        TokenBlock *pop() {
+            std::unique_lock lock(mutex);
+            ready.wait(lock, [&] { return !blocks.empty(); });
+            TokenBlock *block = blocks.front();
+            blocks.pop_front();
+            return block;
+        }
+    };
+};
+
+LineResults parse_lines_pipelined(const ParseTables& tables, std::string_view text) {
+    std::vector<std::string_view> lines = split_lines(text);
+
+    LineResults results;
+    results.status.resize(lines.size());
+    results.serialized.resize(lines.size());
+
+    // two blocks in flight: one is parsed while the other is filled
+    std::vector<TokenBlock> storage(2);
+    BlockQueue free_blocks, full_blocks;
+    for (TokenBlock& block: storage) free_blocks.push(&block);
+
+    // empty block marks the end
+    std::thread tokenizer([&] {
+        std::size_t first = 0;
+        while (first < lines.size()) {
+            TokenBlock *block = free_blocks.pop();
+            block->first = first;
+            block->too_long = lines[first].size() > UINT32_MAX;
+
+            // a line longer than chunk_bytes gets a block of its own
+            const char *begin = lines[first].data();
+            std::size_t end = first + 1;
+            while (!block->too_long && end < lines.size() && end - first < chunk_lines &&
+                   std::size_t(lines[end].data() + lines[end].size() - begin) <= chunk_bytes) {
+                end++;
+            }
+            block->count = end - first;
+
+            if (block->too_long) {
+                block->tokens.clear({});
+            } else {
+                const std::string_view& last = lines[end - 1];
+                block->tokens.clear(std::string_view(begin, last.data() + last.size() - begin));
+                for (std::size_t i = first; i < end; i++) tables.tokenize(lines[i], block->tokens);
+            }
+
+            full_blocks.push(block);
+            first = end;
+        }
+        TokenBlock *end = free_blocks.pop();
+        end->count = 0;
+        full_blocks.push(end);
+    });
+
+    Parser parser(tables);
+    parser.set_error_stream(nullptr);
+    parser.set_ast_storage(Parser::AstStorage::ARENA);
+    AST::TextWriter out;
+    while (true) {
+        TokenBlock *block = full_blocks.pop();
+        if (block->count == 0) break;
+
+        if (block->too_long) {
+            // as parse_view() rejects such lines
+            results.status[block->first] = Parser::ParseStatus::BAD_INPUT;
+            results.serialized[block->first] = "<EMPTY_TREE>";
+            free_blocks.push(block);
+            continue;
+        }
+
+        std::size_t pos = 0;
+        for (std::size_t i = block->first; i < block->first + block->count; i++) {
+            results.status[i] = parser.parse_tokens(block->tokens, pos);
+
+            out.clear();
+            out.write(parser.get_tree(), AST::SERIALIZE);
+            results.serialized[i] = out.view();
+        }
+        free_blocks.push(block);
+    }
+
+    tokenizer.join();
+    return results;
+}
+
+int parse_file_lines(const ParseTables& tables, const std::string& path, LineResults& results,
+                     unsigned n_threads) {
+    SLR::InputFile file;
+    if (file.open(path)) return -1;
+
+    results = parse_lines(tables, file.view(), n_threads);
+    return 0;
+}
+
+int stream_file_lines(const ParseTables& tables, const std::string& path, const LineCallback& on_line,
+                      std::size_t window, unsigned n_threads) {
+    SLR::LineBlockReader reader;
+    if (reader.open(path, window)) return -1;
+
+    std::size_t line = 0;
+    const std::string empty_tree = "<EMPTY_TREE>";
+    std::string_view block;
+    while (true) {
+        switch (reader.next(block)) {
+            case SLR::LineBlockReader::Status::LINES: {
+                LineResults results = parse_lines(tables, block, n_threads);
+                for (std::size_t i = 0; i < results.size(); i++) {
+                    on_line(++line, results.status[i], results.serialized[i]);
+                }
+                break;
+            }
+            case SLR::LineBlockReader::Status::TOO_LONG:
+                on_line(++line, Parser::ParseStatus::BAD_INPUT, empty_tree);
+                break;
+            case SLR::LineBlockReader::Status::END:
+                return 0;
+            case SLR::LineBlockReader::Status::READ_ERR:
+            default:
+                std::cerr << "Failed to read file '" << path << "'\n";
+                return -1;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#include <mutex>
+
+#include "symbol_table.hpp"
+
+namespace AST {
+
+    std::uint32_t SymbolTable::intern(std::string_view name) {
+        {
+            std::shared_lock lock(mutex);
+            auto it = ids.find(name);
+            if (it != ids.end()) return it->second;
+        }
+
+        std::unique_lock lock(mutex);
+        // another thread may have added it between the locks
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+
+        std::uint32_t id = names.size();
+        names.emplace_back(name);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    std::string_view SymbolTable::name(std::uint32_t id) const {
+        std::shared_lock lock(mutex);
+        return names[id];
+    }
+
+    std::size_t SymbolTable::size() const {
+        std::shared_lock lock(mutex);
+        return names.size();
+    }
+
+    SymbolTable& symbols() {
+        static SymbolTable table;
+        return table;
+    }
+};
@@ -1,44 +1,94 @@
 #include <algorithm>
+#include <climits>
 #include <ostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
 #include <variant>
 
 #include "syntax_analyzer.hpp"
 #include "AST.hpp"
 
-using State_t = SyntaxAnalyzer::State_t;
+using State_t = ParseTables::State_t;
 
-template <typename T>
-static void merge_inplace(std::set<T>& dest, const std::set<T>& src) {
-    for (const T& elem: src)
-        dest.insert(elem);
+ParseTables::ParseTables() {
+    for (const NamedAction& action: builtin_actions) {
+        actions[std::string(action.name)] = action.reduce;
+    }
+    use_grammar();
 }
 
+void ParseTables::use_grammar() {
+    numSymbols = grammar.symbols_count();
+    allSymbols.clear();
+    for (int s = 1; s < numSymbols; s++) {
+        allSymbols.push_back(Symbol(s));
+    }
 
-SyntaxAnalyzer::Symbol SyntaxAnalyzer::token_to_symbol(const Token& tok) {
-    switch(tok.type_) {
-        case TokenType::END: return END;
-        case TokenType::NUMBER: return NUM;
-        case TokenType::IDENTIFIER: return ID;
-        case TokenType::OPERATOR: {
-            switch (tok.op_char) {
-                case '+': return PLUS;
-                case '-': return MINUS;
-                case '*': return MUL;
-                case '/': return DIV;
-                case '(': return LBRACKET;
-                case ')': return RBRACKET;
-            }
-        }
-        case TokenType::UNKNOWN: return END;
-        default: return END;
+    // tables of the previous grammar are no longer valid
+    states.clear();
+    lookaheads.clear();
+    action_table = nullptr;
+    states_count = 0;
+}
+
+int ParseTables::load_grammar(std::istream& in) {
+    Grammar loaded;
+    if (loaded.load(in)) return -1;
+
+    grammar = std::move(loaded);
+    grammar_is_builtin = false;
+    use_grammar();
+    return 0;
+}
+
+int ParseTables::load_grammar(const std::string& path) {
+    std::ifstream file_stream(path);
+    if (!file_stream.is_open()) {
+        std::cerr << "Failed to open file '" << path << "'\n";
+        return -1;
     }
+
+    return load_grammar(file_stream);
 }
 
+void ParseTables::bind_action(const std::string& name, reduceFunc *reduce) {
+    actions[name] = reduce;
+}
+
+int ParseTables::bind_reducers() {
+    // the AST has nodes for the arithmetic operators only
+    auto arithmetic = [&](const Production& prod) {
+        if (prod.rhs.size() != 3 || !grammar.is_term[prod.rhs[1]]) return false;
+        const std::string& op = grammar.names[prod.rhs[1]];
+        return op == "+" || op == "-" || op == "*" || op == "/";
+    };
+
+    reducers.clear();
+    for (const Production& prod: grammar) {
+        if (prod.action.empty()) {
+            reducers.push_back(nullptr);
+            continue;
+        }
 
+        auto it = actions.find(prod.action);
+        if (it == actions.end()) {
+            std::cerr << "Semantic action '@" << prod.action << "' is not bound\n";
+            return -1;
+        }
+        if (it->second == reduceBinOp && !arithmetic(prod)) {
+            std::cerr << "Semantic action '@" << prod.action << "' needs an operand, one of + - * / and an operand: ";
+            print_item(std::cerr, Item{int(reducers.size()), -1}) << "\n";
+            return -1;
+        }
+        reducers.push_back(it->second);
+    }
 
-std::ostream& operator<<(std::ostream& os, SyntaxAnalyzer::Symbol s) {
+    reducer_table = reducers.data();
+    return 0;
+}
+
+std::ostream& operator<<(std::ostream& os, ParseTables::Symbol s) {
     const char * const sym_to_text[] = {
         "$", // EPS
         "E0", "E", "T", "F",
@@ -50,140 +100,129 @@ std::ostream& operator<<(std::ostream& os, SyntaxAnalyzer::Symbol s) {
 }
 
 
-std::ostream& SyntaxAnalyzer::Item::print_item(std::ostream& os) {
-
-
-    const Production& prod = ::SyntaxAnalyzer::grammar[id];
-    os << prod.lhs << " -> ";
+std::ostream& ParseTables::print_item(std::ostream& os, Item item) const {
+    const Production& prod = grammar[item.id];
+    os << symbol_name(prod.lhs) << " -> ";
     for (int i = 0; i < prod.rhs.size(); i++) {
-        if (i == dotPos) os << "· ";
-        os << prod.rhs[i] << " ";
+        if (i == item.dotPos) os << "· ";
+        os << symbol_name(prod.rhs[i]) << " ";
     }
 
-    if (dotPos == prod.rhs.size()) os << "· ";
-
+    if (item.dotPos == prod.rhs.size()) os << "· ";
 
     return os;
 }
 
-std::ostream& operator<<(std::ostream& os, SyntaxAnalyzer::Item item) {
-    return item.print_item(os);
-}
-
-State_t SyntaxAnalyzer::state_closure(State_t I) {
-    State_t result = I;
-
-    while (true) {
-        size_t cur_size = result.size();
-
-        // collecting all non-terminals that are candidates for
-        // new productions in closure
-        std::set<Symbol> newLhs{};
-        for (auto item: result) {
-            Symbol curSym = get_item_symbol(item);
-            if (!isTerm(curSym)) newLhs.insert(curSym);
+void ParseTables::index_items() {
+    items.clear();
+    item_offset.clear();
+    for (int i = 0; i < grammar.size(); i++) {
+        item_offset.push_back(items.size());
+        for (int dot = 0; dot <= grammar[i].rhs.size(); dot++) {
+            items.push_back({i, dot});
         }
+    }
 
-        // looping over all productions and adding them to closure if
-        // we found previously it's lhs
-        for (int i = 0; i < grammar.size(); i++) {
-            if (newLhs.contains(grammar[i].lhs)) {
-                result.insert(Item{i, 0});
-            }
-        }
+    // closure of A contains items of every B derivable as leftmost symbol from A:
+    // A -> B smth pulls closure of B into closure of A
+    nonterm_closure.assign(numSymbols, State_t(items.size()));
+    for (int i = 0; i < grammar.size(); i++) {
+        nonterm_closure[grammar[i].lhs].set(item_offset[i]);
+    }
 
-        if (result.size() == cur_size) {
-            // no new items
-            break;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Production& prod: grammar) {
+            if (prod.rhs.empty() || isTerm(prod.rhs[0])) continue;
+            changed |= nonterm_closure[prod.lhs].merge(nonterm_closure[prod.rhs[0]]);
         }
     }
-
-    return result;
 }
 
-State_t SyntaxAnalyzer::state_goto(State_t I, Symbol s) {
-    State_t result{};
+State_t ParseTables::state_closure(const State_t& kernel) {
+    State_t result = kernel;
 
-    for (auto item: I) {
-        if (get_item_symbol(item) == s) {
-            result.insert({item.id, item.dotPos+1});
-        }
-    }
+    kernel.for_each([&](std::size_t idx) {
+        Symbol s = get_item_symbol(items[idx]);
+        if (!isTerm(s)) result.merge(nonterm_closure[s]);
+    });
 
-    return state_closure(result);
+    return result;
 }
 
-std::vector<State_t> SyntaxAnalyzer::build_canonic_states() {
-    // starting from closure({E0->E})
-    std::vector<State_t> result = {state_closure({Item{0, 0} })};
+std::vector<State_t> ParseTables::build_canonic_states() {
+    index_items();
 
-    for (int i = 0; i < result.size(); i++) {
-        // collecting all symbols after dot
-        // other symbols will produce empty goto
+    std::vector<State_t> result;
+    state_transitions.clear();
 
-        std::set<Symbol> symbols_for_goto;
-        for (Item item: result[i]) {
-            symbols_for_goto.insert(get_item_symbol(item));
+    // closure is a function of kernel, so states are deduplicated by kernel
+    std::unordered_map<State_t, int, State_t::Hash> kernel_to_state;
+    auto intern = [&](const State_t& kernel) {
+        auto [it, inserted] = kernel_to_state.try_emplace(kernel, result.size());
+        if (inserted) {
+            result.push_back(state_closure(kernel));
+            state_transitions.emplace_back();
         }
-        symbols_for_goto.erase(END); // $ must not be included
+        return it->second;
+    };
 
-        for (Symbol s: symbols_for_goto) {
-            State_t new_state = state_goto(result[i], s);
-            if (new_state.empty()) continue;
+    // starting from closure({E0->E})
+    State_t start(items.size());
+    start.set(item_offset[0]);
+    intern(start);
 
+    // kernels of goto(I, s) for all symbols s, filled in one pass over I
+    std::vector<State_t> goto_kernels(numSymbols, State_t(items.size()));
+    std::vector<Symbol> symbols_for_goto;
 
-            auto new_state_it = std::find(result.begin(), result.end(), new_state);
-            int new_state_idx = new_state_it - result.begin();
+    for (int i = 0; i < result.size(); i++) {
+        result[i].for_each([&](std::size_t idx) {
+            const Item& item = items[idx];
+            if (item.dotPos == grammar[item.id].rhs.size()) return;
 
-            // saving information for goto's
-            state_transitions[{i, s}] = new_state_idx;
+            Symbol s = get_item_symbol(item);
+            if (!goto_kernels[s].any()) symbols_for_goto.push_back(s);
+            goto_kernels[s].set(idx + 1); // same production, dot moved
+        });
 
-            // pushing new state if its not in states
-            if (new_state_it == result.end())
-                result.push_back(new_state);
+        // ascending symbol order keeps state numbering stable
+        std::sort(symbols_for_goto.begin(), symbols_for_goto.end());
+        for (Symbol s: symbols_for_goto) {
+            int new_state_idx = intern(goto_kernels[s]);
+            state_transitions[i].push_back({s, new_state_idx});
+            goto_kernels[s].clear();
         }
-
+        symbols_for_goto.clear();
     }
+
     return result;
 }
 
-std::set<SyntaxAnalyzer::Symbol> SyntaxAnalyzer::first_of_string(const std::vector<Symbol>& rhs) {
-    std::set<Symbol> temp = {}; //? maybe EPS must be here
-    bool nullable = true;
-
-    // looping over all symbols in rhs of rule
-    for (int i = 0; i < rhs.size(); i++) {
-        if (!nullable) break;
-
-        bool temp_has_eps = temp.contains(EPS);
-
-        std::set<Symbol>& Xi_first = FIRST[rhs[i]];
+ParseTables::SymbolSet ParseTables::first_of_string(std::span<const Symbol> rhs) {
+    SymbolSet result(numSymbols);
 
-        merge_inplace(temp, Xi_first);
-        // merging FIRST[X_i] without END symbol
-        if (!temp_has_eps) temp.erase(EPS);
-
-        if (!Xi_first.contains(EPS)) {
-            nullable = false;
+    // looping over all symbols in rhs while they are nullable
+    for (Symbol s: rhs) {
+        const SymbolSet& s_first = FIRST[s];
+        result.merge(s_first);
+        if (!s_first.test(EPS)) {
+            result.reset(EPS);
+            return result;
         }
-
     }
 
-    if (nullable) temp.insert(EPS);
-
-    return temp;
+    result.set(EPS);
+    return result;
 }
 
 
-int SyntaxAnalyzer::compute_first() {
-    FIRST.clear();
+int ParseTables::compute_first() {
     // initialization: terminals have itself in their first set
+    FIRST.assign(numSymbols, SymbolSet(numSymbols));
     for (const Symbol s: allSymbols) {
-        if (isTerm(s)) {
-            FIRST[s] = {s};
-        } else {
-            FIRST[s] = {};
-        }
+        if (isTerm(s)) FIRST[s].set(s);
     }
 
     bool changed = true;
@@ -192,135 +231,453 @@ int SyntaxAnalyzer::compute_first() {
 
         // looping over all grammar rules
         for (const Production& prod: grammar) {
-            std::set<Symbol> rhs_first = first_of_string(prod.rhs);
-
-            std::size_t prev_size = FIRST[prod.lhs].size();
-            merge_inplace(FIRST[prod.lhs], rhs_first);
-            if (FIRST[prod.lhs].size() > prev_size)
-                changed = true;
-
+            changed |= FIRST[prod.lhs].merge(first_of_string(prod.rhs));
         }
-
     }
 
     return 0;
 }
 
-int SyntaxAnalyzer::compute_follow() {
+int ParseTables::compute_follow() {
     // init
-    FOLLOW.clear();
-    FOLLOW[start_symbol] = {END};
+    FOLLOW.assign(numSymbols, SymbolSet(numSymbols));
+    FOLLOW[grammar.start_symbol].set(grammar.end_symbol);
 
     bool changed = true;
     while (changed) {
         changed = false;
 
         for (const Production& prod: grammar) {
+            // walking rhs from the end, trailer is FIRST of the remaining string
+            // plus FOLLOW of lhs while the remaining string is nullable
+            SymbolSet trailer = FOLLOW[prod.lhs];
+
+            for (int i = prod.rhs.size() - 1; i >= 0; i--) {
+                Symbol cur = prod.rhs[i];
+                if (isTerm(cur)) {
+                    trailer.clear();
+                    trailer.set(cur);
+                    continue;
+                }
 
-            for (int i = 0; i < prod.rhs.size(); i++) {
-                // skipping terminals
-                if (isTerm(prod.rhs[i])) continue;
+                changed |= FOLLOW[cur].merge(trailer);
 
-                Symbol lhs = prod.lhs;
-                Symbol cur = prod.rhs[i]; // nonterm
-                std::size_t prev_size = FOLLOW[cur].size();
+                if (!FIRST[cur].test(EPS)) trailer.clear();
+                trailer.merge(FIRST[cur]);
+                trailer.reset(EPS);
+            }
+        }
 
-                // 1
-                std::vector<Symbol> remain(prod.rhs.begin()+i+1, prod.rhs.end());
-                std::set<Symbol> first_of_remain = first_of_string(remain);
-                bool first_has_eps = first_of_remain.contains(EPS);
+    }
+    return 0;
+}
 
-                // merging without EPS
-                first_of_remain.erase(EPS);
-                merge_inplace(FOLLOW[cur], first_of_remain);
+/* ==================== LALR(1) LOOKAHEADS ============================ */
+/*
+    DeRemer & Pennello, over nonterminal transitions (p, A) of the LR(0) automaton:
+        DR(p, A)      terminals shifted in goto(p, A)
+        Read(p, A)    DR(p, A) + Read(r, C) for nullable C, where r = goto(p, A)
+        Follow(p, A)  Read(p, A) + Follow(p', B) for B -> b A g, p' --b--> p, g nullable
+        LA(q, A -> w) union of Follow(p, A) for p --w--> q
+    Read and Follow are both computed by digraph()
+*/
+namespace {
+    /// @brief F(x) |= F(y) for every y reachable from x in relation R,
+    /// members of a strongly connected component get equal sets
+    void digraph(std::vector<SLR::Bitset>& F, const std::vector<std::vector<int>>& R) {
+        const int done = INT_MAX;
+        std::vector<int> depth(F.size(), 0);
+        std::vector<int> stack;
+
+        auto traverse = [&](auto& self, int x) -> void {
+            stack.push_back(x);
+            int d = stack.size();
+            depth[x] = d;
+
+            for (int y: R[x]) {
+                if (depth[y] == 0) self(self, y);
+                depth[x] = std::min(depth[x], depth[y]);
+                F[x].merge(F[y]);
+            }
 
-                // 2
-                if (remain.empty() || first_has_eps) {
-                    merge_inplace(FOLLOW[cur], FOLLOW[lhs]);
+            if (depth[x] == d) {
+                while (true) {
+                    int top = stack.back();
+                    stack.pop_back();
+                    depth[top] = done;
+                    if (top == x) break;
+                    F[top] = F[x];
                 }
+            }
+        };
+
+        for (std::size_t x = 0; x < F.size(); x++) {
+            if (depth[x] == 0) traverse(traverse, x);
+        }
+    }
+};
+
+int ParseTables::transition_index(int state, Symbol s) const {
+    const auto& trans = state_transitions[state];
+    auto it = std::lower_bound(trans.begin(), trans.end(), s,
+                               [](const std::pair<Symbol, int>& t, Symbol sym) { return t.first < sym; });
+    if (it == trans.end() || it->first != s) return -1;
+    return it - trans.begin();
+}
 
-                if (FOLLOW[cur].size() > prev_size) changed = true;
+int ParseTables::compute_lalr_lookaheads() {
+    // numbering nonterminal transitions, nt_id[trans_offset[p] + k] is the number
+    // of k-th transition of state p, -1 for terminals
+    std::vector<std::pair<int, Symbol>> transitions;
+    std::vector<int> trans_offset;
+    std::vector<int> nt_id;
+    for (int p = 0; p < states.size(); p++) {
+        trans_offset.push_back(nt_id.size());
+        for (auto [sym, j]: state_transitions[p]) {
+            if (isTerm(sym)) {
+                nt_id.push_back(-1);
+            } else {
+                nt_id.push_back(transitions.size());
+                transitions.push_back({p, sym});
             }
         }
+    }
+
+    auto transition_id = [&](int state, Symbol s) {
+        return nt_id[trans_offset[state] + transition_index(state, s)];
+    };
+    auto goto_state = [&](int state, Symbol s) {
+        return state_transitions[state][transition_index(state, s)].second;
+    };
 
+    /* ---------- DR and reads ---------- */
+    std::vector<SymbolSet> F(transitions.size(), SymbolSet(numSymbols));
+    std::vector<std::vector<int>> relation(transitions.size());
+
+    for (int t = 0; t < transitions.size(); t++) {
+        auto [p, A] = transitions[t];
+        int r = goto_state(p, A);
+        for (auto [sym, j]: state_transitions[r]) {
+            if (isTerm(sym)) F[t].set(sym);
+            else if (FIRST[sym].test(EPS)) relation[t].push_back(transition_id(r, sym));
+        }
+
+        // start' -> start · accepts on end symbol
+        if (states[r].test(item_offset[0] + 1)) F[t].set(grammar.end_symbol);
     }
+
+    digraph(F, relation);
+
+    /* ---------- includes and lookback ---------- */
+    lookaheads.assign(states.size(), {});
+    for (int q = 0; q < states.size(); q++) {
+        states[q].for_each([&](std::size_t idx) {
+            const Item& item = items[idx];
+            if (item.id != 0 && item.dotPos == grammar[item.id].rhs.size())
+                lookaheads[q].push_back({item.id, SymbolSet(numSymbols)});
+        });
+    }
+
+    std::vector<std::vector<int>> prods_of(numSymbols);
+    for (int i = 0; i < grammar.size(); i++) prods_of[grammar[i].lhs].push_back(i);
+
+    // {lookahead set, transition it looks back to}
+    std::vector<std::pair<SymbolSet*, int>> lookback;
+    std::vector<bool> nullable_from;
+
+    for (auto& rel: relation) rel.clear();
+    for (int t = 0; t < transitions.size(); t++) {
+        auto [start, B] = transitions[t];
+        for (int prod_id: prods_of[B]) {
+            const std::vector<Symbol>& rhs = grammar[prod_id].rhs;
+
+            nullable_from.assign(rhs.size() + 1, true);
+            for (int i = rhs.size() - 1; i >= 0; i--) {
+                nullable_from[i] = nullable_from[i + 1] && !isTerm(rhs[i]) && FIRST[rhs[i]].test(EPS);
+            }
+
+            // walking B -> rhs from start state
+            int p = start;
+            for (int i = 0; i < rhs.size(); i++) {
+                if (!isTerm(rhs[i]) && nullable_from[i + 1])
+                    relation[transition_id(p, rhs[i])].push_back(t);
+                p = goto_state(p, rhs[i]);
+            }
+
+            for (auto& [prod, la]: lookaheads[p]) {
+                if (prod == prod_id) lookback.push_back({&la, t});
+            }
+        }
+    }
+
+    digraph(F, relation);
+
+    for (auto [la, t]: lookback) la->merge(F[t]);
+
+    stats.nonterm_transitions = transitions.size();
     return 0;
 }
 
-int SyntaxAnalyzer::build_action_goto() {
-    action_goto.clear();
-    action_goto.resize(states.size());
+const ParseTables::SymbolSet& ParseTables::reduce_lookahead(int state, int prod, Lookahead lookahead) const {
+    if (lookahead == Lookahead::LALR) {
+        for (const auto& [p, la]: lookaheads[state]) {
+            if (p == prod) return la;
+        }
+    }
+    return FOLLOW[grammar[prod].lhs];
+}
+
+int ParseTables::build_action_goto(Lookahead lookahead) {
+    if (states.size() > INT16_MAX || grammar.size() > INT16_MAX) {
+        std::cerr << "Too many states for packed action table: " << states.size() << "\n";
+        return -1;
+    }
 
-    int conflicts_count = 0;
+    action_goto.assign(states.size() * numSymbols, ActionEntry{});
+
+    reduce_info.clear();
+    for (const Production& prod: grammar) {
+        reduce_info.push_back({std::uint16_t(prod.lhs), std::uint16_t(prod.rhs.size())});
+    }
 
     auto report_conflict = [&](int state_idx, const Item& item, Symbol s, std::string msg) {
-        const ActionEntry& entry = action_goto[state_idx][s];
+        const ActionEntry& entry = cell(state_idx, s);
         std::cout << "Grammar conflict:" << msg << "\n" <<
             "state " << state_idx << "\n" <<
-            "item " << item << "\n" <<
-            "problem sym" << s << "\n" <<
+            "item ";
+        print_item(std::cout, item) << "\n" <<
+            "problem sym" << symbol_name(s) << "\n" <<
             "type" << ((entry.type == SHIFT) ? "SHIFT" : "REDUCE") << "\n";
 
-        conflicts_count++;
+        if (entry.type == SHIFT) stats.shift_reduce++;
+        else stats.reduce_reduce++;
     };
 
     for (std::size_t state_idx = 0; state_idx < states.size(); state_idx++) {
+        // shifts on terminals, gotos on nonterminals
+        for (auto [sym, j]: state_transitions[state_idx]) {
+            cell(state_idx, sym) = {isTerm(sym) ? SHIFT : GOTO, j};
+        }
 
-        for (const Item& item: states[state_idx]) {
-
+        // reductions for items with dot at the end
+        states[state_idx].for_each([&](std::size_t idx) {
+            const Item& item = items[idx];
             const Production& prod = grammar[item.id];
+            if (item.dotPos != prod.rhs.size()) return;
 
-            Symbol cur_sym = get_item_symbol(item);
+            if (prod.lhs == grammar.start_symbol) {
+                cell(state_idx, grammar.end_symbol) = {ACCEPT, 0};
+                return;
+            }
 
-            if (cur_sym == END) {
-                if (prod.lhs == start_symbol) {
-                    action_goto[state_idx][END] = {ACCEPT, 0};
+            reduce_lookahead(state_idx, item.id, lookahead).for_each([&](std::size_t fol_sym) {
+                ActionEntry& entry = cell(state_idx, Symbol(fol_sym));
+                if (entry.type != ERROR) {
+                    report_conflict(state_idx, item, Symbol(fol_sym), "REDUCE");
                 } else {
-                    for (Symbol fol_sym : FOLLOW[prod.lhs]) {
-                        ActionEntry& entry = action_goto[state_idx][fol_sym];
-                        if (entry.type != ERROR) {
-                            report_conflict(state_idx, item, fol_sym, "REDUCE");
-                        } else {
-                            entry = {REDUCE, item.id};
-                        }
-                    }
-                }
-            } else {
-                int j = state_transitions[{state_idx, cur_sym}];
-                ActionEntry& entry = action_goto[state_idx][cur_sym];
-                if (entry.type != ERROR &&
-                    !(entry.type == SHIFT && entry.val == j) ) {
-                    report_conflict(state_idx, item, cur_sym, "SHIFT");
-                } else {
-                    entry = {SHIFT, j};
+                    entry = {REDUCE, item.id};
                 }
+            });
+        });
+    }
 
-            }
+    return stats.conflicts();
+}
+
+
+/* ==================== COMPILE-TIME TABLES ============================ */
+namespace {
+    using Symbol = ParseTables::Symbol;
+
+    constexpr std::size_t builtin_prod_count = std::size(ParseTables::builtin_grammar);
+    constexpr std::size_t builtin_max_states = 64;
+
+    constexpr auto builtin_spec = [] {
+        SLR::GrammarSpec<ParseTables::builtinSymbols, builtin_prod_count, 3> spec{};
+        for (int s = 0; s < ParseTables::builtinSymbols; s++) {
+            spec.is_term[s] = ParseTables::isBuiltinTerm(Symbol(s));
+        }
+        for (std::size_t p = 0; p < builtin_prod_count; p++) {
+            const ParseTables::ProductionSpec& prod = ParseTables::builtin_grammar[p];
+            spec.lhs[p] = prod.lhs;
+            spec.rhs_len[p] = prod.rhs_len();
+            for (int k = 0; k < prod.rhs_len(); k++) spec.rhs[p][k] = prod.rhs[k];
         }
+        spec.end_sym = ParseTables::END;
+        return spec;
+    }();
 
-    }
+    constexpr auto builtin_raw = SLR::build_tables<builtin_max_states>(builtin_spec);
+    static_assert(!builtin_raw.overflow, "builtin_max_states is too small for the built-in grammar");
+    static_assert(builtin_raw.conflicts == 0, "built-in grammar is not SLR(1)");
 
-    for (auto [pair, j]  : state_transitions) {
-        int i = pair.first;
-        Symbol sym = pair.second;
-        if (!isTerm(sym)) {
-            action_goto[i][sym] = {GOTO, j};
+    constexpr auto builtin_action_goto = SLR::trim_tables<builtin_raw.n_states>(builtin_raw);
+
+    constexpr auto builtin_reduce_info = [] {
+        std::array<ParseTables::ReduceInfo, builtin_prod_count> info{};
+        for (std::size_t p = 0; p < builtin_prod_count; p++) {
+            const ParseTables::ProductionSpec& prod = ParseTables::builtin_grammar[p];
+            info[p] = {std::uint16_t(prod.lhs), std::uint16_t(prod.rhs_len())};
         }
-    }
+        return info;
+    }();
+};
 
-    return conflicts_count;
-}
 
+int ParseTables::init(TableSource source, Lookahead lookahead) {
+    if (bind_reducers()) return -1;
+    stats = {};
+    use_compressed = false;
+
+    if (source == TableSource::COMPILED) {
+        if (!grammar_is_builtin) {
+            std::cerr << "Compiled tables exist only for the built-in grammar\n";
+            return -1;
+        }
+        if (lookahead != Lookahead::SLR) {
+            std::cerr << "Compiled tables are SLR(1), use TableSource::RUNTIME for LALR(1)\n";
+            return -1;
+        }
+        action_table = builtin_action_goto.data();
+        reduce_table = builtin_reduce_info.data();
+        states_count = builtin_raw.n_states;
+        stats.states = states_count;
+        stats.dense_bytes = states_count * numSymbols * sizeof(ActionEntry);
+        return 0;
+    }
 
-int SyntaxAnalyzer::init() {
     states = build_canonic_states();
     compute_first();
     compute_follow();
-    return build_action_goto();
+    lookaheads.clear();
+    if (lookahead == Lookahead::LALR) compute_lalr_lookaheads();
+    int conflicts = build_action_goto(lookahead);
+    if (conflicts < 0) {
+        // no tables rather than stale or partial ones
+        action_goto.clear();
+        action_table = nullptr;
+        reduce_table = nullptr;
+        states_count = 0;
+        return -1;
+    }
+
+    action_table = action_goto.data();
+    reduce_table = reduce_info.data();
+    states_count = states.size();
+    stats.states = states_count;
+    stats.dense_bytes = action_goto.size() * sizeof(ActionEntry);
+    return conflicts;
+}
+
+int ParseTables::init_from_file(const std::string& path) {
+    auto file = std::make_unique<SLR::MappedTableFile>();
+    if (file->open(path)) return -1;
+
+    if (bind_reducers()) return -1;
+
+    const SLR::TableFileHeader& header = file->header();
+    if (header.n_symbols != numSymbols || header.n_productions != grammar.size()) {
+        std::cerr << "Table file '" << path << "' was built for another grammar\n";
+        return -1;
+    }
+
+    const ReduceInfo *prods = file->reduce_info();
+    for (std::size_t i = 0; i < grammar.size(); i++) {
+        if (prods[i].lhs != grammar[i].lhs || prods[i].rhs_len != grammar[i].rhs.size()) {
+            std::cerr << "Table file '" << path << "' was built for another grammar\n";
+            return -1;
+        }
+    }
+    // same shape is not enough: terminals must be the same tokens
+    for (int s = 0; s < numSymbols; s++) {
+        const char *name = file->symbol_name(s);
+        if (!name || name != grammar.names[s]) {
+            std::cerr << "Table file '" << path << "' was built for another grammar\n";
+            return -1;
+        }
+    }
+
+    // the parse loop indexes the tables with cell values without checks
+    if (header.n_states == 0) {
+        std::cerr << "Table file '" << path << "' has no states\n";
+        return -1;
+    }
+    const ActionEntry *actions = file->actions();
+    std::vector<std::uint8_t> has_goto(numSymbols, false), reduced(numSymbols, false);
+    for (std::size_t i = 0; i < std::size_t(header.n_states) * header.n_symbols; i++) {
+        const ActionEntry& cell = actions[i];
+        std::size_t column = i % header.n_symbols;
+        // tokens of terminals not in the grammar have column EPS, nonterminal columns hold gotos
+        bool nonterminal = column != EPS && !grammar.is_term[column];
+        bool valid = false;
+        switch (cell.type) {
+            case ERROR:
+                valid = true;
+                break;
+            case ACCEPT:
+                valid = column != EPS && !nonterminal;
+                break;
+            case SHIFT:
+                valid = column != EPS && !nonterminal && cell.val >= 0 && std::uint32_t(cell.val) < header.n_states;
+                break;
+            case GOTO:
+                valid = nonterminal && cell.val >= 0 && std::uint32_t(cell.val) < header.n_states;
+                has_goto[column] = true;
+                break;
+            case REDUCE:
+                // production 0 is accepted, not reduced, and its lhs has no gotos
+                valid = column != EPS && !nonterminal && cell.val > 0 && std::uint32_t(cell.val) < header.n_productions;
+                if (valid) reduced[prods[cell.val].lhs] = true;
+                break;
+        }
+        if (!valid) {
+            std::cerr << "Table file '" << path << "' has a bad action in state " << i / header.n_symbols
+                      << " for symbol " << column << "\n";
+            return -1;
+        }
+    }
+    for (int s = 0; s < numSymbols; s++) {
+        if (reduced[s] && !has_goto[s]) {
+            std::cerr << "Table file '" << path << "' reduces to " << grammar.names[s] << " but has no goto on it\n";
+            return -1;
+        }
+    }
+
+    table_file = std::move(file);
+    action_table = table_file->actions();
+    reduce_table = prods;
+    states_count = header.n_states;
+    stats = {};
+    stats.states = states_count;
+    stats.dense_bytes = states_count * numSymbols * sizeof(ActionEntry);
+    use_compressed = false;
+    return 0;
+}
+
+int ParseTables::set_table_layout(TableLayout layout) {
+    if (!action_table) {
+        std::cerr << "Parser tables are not initialized\n";
+        return -1;
+    }
+
+    use_compressed = layout == TableLayout::COMPRESSED;
+    if (use_compressed) {
+        compressed_tables = SLR::compress_tables(action_table, states_count, numSymbols, grammar.is_term);
+        stats.compressed_bytes = compressed_tables.size_bytes();
+    } else {
+        compressed_tables = {};
+        stats.compressed_bytes = 0;
+    }
+    return 0;
 }
 
+int ParseTables::export_binary_tables(const std::string& path) const {
+    return SLR::write_table_file(path, states_count, numSymbols, action_table,
+                                 grammar.size(), reduce_table, grammar.names);
+}
 
-std::ostream& SyntaxAnalyzer::print_action(std::ostream& os, const ActionEntry& entry) {
+
+std::ostream& ParseTables::print_action(std::ostream& os, const ActionEntry& entry) const {
     switch (entry.type) {
         case ERROR: break;
         case ACCEPT: os << "A"; break;
@@ -337,33 +694,54 @@ std::ostream& SyntaxAnalyzer::print_action(std::ostream& os, const ActionEntry&
 }
 
 
-void SyntaxAnalyzer::dump_tables(const std::string action_table_path) {
-    std::cout << "=============FIRST==============\n";
-    for (Symbol s: allSymbols) {
-        std::cout << s << " -> ";
-        for (Symbol f: FIRST[s]) {
-            std::cout << f << " ";
+void ParseTables::dump_tables(const std::string action_table_path) const {
+    if (states.empty()) {
+        // tables were not built at runtime: only action/goto table is known
+        std::cout << "Canonic states are not built, use init(TableSource::RUNTIME)\n";
+    } else {
+        std::cout << "=============FIRST==============\n";
+        for (Symbol s: allSymbols) {
+            std::cout << symbol_name(s) << " -> ";
+            FIRST[s].for_each([&](std::size_t f) { std::cout << symbol_name(Symbol(f)) << " "; });
+            std::cout << "\n";
         }
-        std::cout << "\n";
-    }
 
-    std::cout << "============FOLLOW==============\n";
-    for (Symbol s: allSymbols) {
-        std::cout << s << " -> ";
-        for (Symbol f: FOLLOW[s]) {
-            std::cout << f << " ";
+        std::cout << "============FOLLOW==============\n";
+        for (Symbol s: allSymbols) {
+            std::cout << symbol_name(s) << " -> ";
+            FOLLOW[s].for_each([&](std::size_t f) { std::cout << symbol_name(Symbol(f)) << " "; });
+            std::cout << "\n";
         }
-        std::cout << "\n";
-    }
 
-    std::cout << "============ STATES ===============\n";
-    for (int i = 0; i < states.size(); i++) {
-        std::cout << "I_" << i << ":\n";
-        for (const auto& item: states[i]) {
-            std::cout << "\t" << item << "\n";
+        std::cout << "============ STATES ===============\n";
+        for (int i = 0; i < states.size(); i++) {
+            std::cout << "I_" << i << ":\n";
+            states[i].for_each([&](std::size_t idx) {
+                std::cout << "\t";
+                print_item(std::cout, items[idx]) << "\n";
+            });
+        }
+
+        if (!lookaheads.empty()) {
+            std::cout << "========== LALR LOOKAHEADS ==========\n";
+            for (int i = 0; i < states.size(); i++) {
+                for (const auto& [prod, la]: lookaheads[i]) {
+                    std::cout << "I_" << i << ": ";
+                    print_item(std::cout, Item{prod, int(grammar[prod].rhs.size())}) << "| ";
+                    la.for_each([&](std::size_t f) { std::cout << symbol_name(Symbol(f)) << " "; });
+                    std::cout << "\n";
+                }
+            }
         }
     }
 
+    std::cout << "States: " << stats.states << ", conflicts: " << stats.conflicts()
+              << " (shift/reduce " << stats.shift_reduce
+              << ", reduce/reduce " << stats.reduce_reduce << ")\n";
+    std::cout << "Table size: " << stats.dense_bytes << " bytes dense";
+    if (use_compressed) std::cout << ", " << stats.compressed_bytes << " bytes compressed";
+    std::cout << "\n";
+
     std::ofstream csv(action_table_path);
     if (!csv.good() ) {
         std::cerr << "Failed to open file" << action_table_path << "\n";
@@ -371,16 +749,16 @@ void SyntaxAnalyzer::dump_tables(const std::string action_table_path) {
         //header
         csv << "Sym ";
         for (Symbol sym: allSymbols) {
-            csv << ", " << '"' << sym << '"';
+            csv << ", " << '"' << symbol_name(sym) << '"';
         }
         csv << "\n";
 
         //body
-        for (int i = 0; i < states.size(); i++) {
+        for (int i = 0; i < states_count; i++) {
             csv << i+1;
             for (Symbol sym: allSymbols) {
                 csv << ", ";
-                print_action(csv, action_goto[i][sym]);
+                print_action(csv, action(i, sym));
             }
             csv << "\n";
         }
@@ -391,51 +769,82 @@ void SyntaxAnalyzer::dump_tables(const std::string action_table_path) {
 }
 
 
-void SyntaxAnalyzer::report_error(int state, const Token& tok) {
-    std::cout << "Error at " << tok.line_ << ":" << tok.pos_ << "\n";
-    std::cout << "Got '" << tok.lexeme_ << "', expected either of {";
-    for (Symbol s: allSymbols) {
-        if (isTerm(s) && action_goto[state][s].type != ERROR) {
-            std::cout << s << " ";
+void Parser::report_error(int state, const Token& tok, std::string_view source) {
+    if (!error_stream) return;
+    std::ostream& os = *error_stream;
+
+    os << "Error at " << tok.line_ << ":" << tok.pos_ << "\n";
+    os << "Got '" << tok.lexeme(source) << "', expected either of {";
+    for (Symbol s: tables.allSymbols) {
+        if (tables.isTerm(s) && tables.action(state, s).type != SLR::ERROR) {
+            os << tables.symbol_name(s) << " ";
         }
     }
 
-    std::cout << " }\n";
+    os << " }\n";
 }
 
-void SyntaxAnalyzer::set_log_stream(std::ostream& os) {
-    parse_log_stream = &os;
+void Parser::report_depth(const Token& tok) {
+    if (!error_stream) return;
+    *error_stream << "Expression is nested too deeply at " << tok.line_ << ":" << tok.pos_
+                  << ": more than " << limits.max_depth << " parse stack entries\n";
 }
 
+void Parser::set_log_stream(std::ostream& os) {
+    parse_log_stream = &os;
+}
 
-/* ==================== REDUCERS ====================================== */
-void reduceBinOp(std::vector<std::variant<Token, AST::NodePtr>>& ast) {
-    AST::NodePtr right = std::get<AST::NodePtr>(ast.back());
-    ast.pop_back();
+void Parser::set_error_stream(std::ostream *os) {
+    error_stream = os;
+}
 
-    Token binOp        = std::get<Token>(ast.back());
-    ast.pop_back();
 
-    AST::NodePtr left  = std::get<AST::NodePtr>(ast.back());
-    ast.pop_back();
+/* ==================== REDUCERS ====================================== */
+void reduceBinOp(ValueStack& ast, const ReduceContext& ctx) {
+    Token binOp = std::get<Token>(ast[ast.size() - 2]);
 
-    AST::Operator op;
+    // bind_reducers() puts this reducer on arithmetic operators only
+    AST::Operator op = AST::PLUS;
     switch (binOp.op_char) {
-        case '+': op = AST::PLUS; break;
         case '-': op = AST::MINUS; break;
         case '*': op = AST::MUL; break;
         case '/': op = AST::DIV; break;
+        default: break;
     }
 
-    ast.push_back(AST::makeBinOp(left, op, right));
+    if (ctx.postfix) {
+        // operands are already in place
+        ast.erase(ast.end() - 3, ast.end());
+        ctx.postfix->push_back({AST::PostfixOp::BINOP, op});
+        ast.push_back(AST::NodeIndex(ctx.postfix->size() - 1));
+        return;
+    }
+    if (ctx.tree) {
+        AST::NodeIndex right = std::get<AST::NodeIndex>(ast.back());
+        AST::NodeIndex left = std::get<AST::NodeIndex>(ast[ast.size() - 3]);
+        ast.erase(ast.end() - 3, ast.end());
+        ast.push_back(ctx.tree->add_binop(left, op, right));
+        return;
+    }
+
+    AST::NodePtr right = std::get<AST::NodePtr>(std::move(ast.back()));
+    ast.pop_back();
+
+    ast.pop_back(); // operator
+
+    AST::NodePtr left  = std::get<AST::NodePtr>(std::move(ast.back()));
+    ast.pop_back();
+
+    if (ctx.dag) ast.push_back(ctx.dag->makeBinOp(std::move(left), op, std::move(right)));
+    else ast.push_back(AST::makeBinOp(std::move(left), op, std::move(right)));
 }
 
-void reduceParen(std::vector<std::variant<Token, AST::NodePtr>>& ast) {
+void reduceParen(ValueStack& ast, const ReduceContext&) {
     // simply removing brackets, there is no need for them in AST
 
     ast.pop_back(); // bracket
 
-    std::variant<Token, AST::NodePtr> node = std::move(ast.back());
+    ValueStack::value_type node = std::move(ast.back());
     ast.pop_back(); // AST Node
 
     ast.pop_back(); // bracket
@@ -443,121 +852,242 @@ void reduceParen(std::vector<std::variant<Token, AST::NodePtr>>& ast) {
     ast.push_back(node); // moving node back
 }
 
-void reduceNumId(std::vector<std::variant<Token, AST::NodePtr>>& ast) {
+void reduceNumId(ValueStack& ast, const ReduceContext& ctx) {
     Token tok = std::get<Token>(ast.back());
     ast.pop_back();
 
     if (tok.type_ == TokenType::IDENTIFIER) {
-        ast.push_back(AST::makeId(tok.lexeme_));
+        std::uint32_t name_id = ctx.symbols.intern(tok.lexeme(ctx.source));
+        if (ctx.postfix) {
+            ctx.postfix->push_back({AST::PostfixOp::ID, std::int32_t(name_id)});
+            ast.push_back(AST::NodeIndex(ctx.postfix->size() - 1));
+        } else if (ctx.tree) {
+            ast.push_back(ctx.tree->add_id(name_id));
+        } else if (ctx.dag) {
+            ast.push_back(ctx.dag->makeId(name_id));
+        } else {
+            ast.push_back(AST::makeId(name_id));
+        }
     } else if (tok.type_ == TokenType::NUMBER) {
-        ast.push_back(AST::makeNum(tok.int_val));
+        if (ctx.postfix) {
+            ctx.postfix->push_back({AST::PostfixOp::NUM, tok.int_val});
+            ast.push_back(AST::NodeIndex(ctx.postfix->size() - 1));
+        } else if (ctx.tree) {
+            ast.push_back(ctx.tree->add_num(tok.int_val));
+        } else if (ctx.dag) {
+            ast.push_back(ctx.dag->makeNum(tok.int_val));
+        } else {
+            ast.push_back(AST::makeNum(tok.int_val));
+        }
     } else {
         std::cerr << "Reduce error: wrong token type (expected number or identifier)\n";
     }
 }
 
 /* =============================== Main parsing loop ============================ */
-SyntaxAnalyzer::ParseStatus SyntaxAnalyzer::parse() {
+Parser::ParseStatus Parser::parse() {
     return parse(std::cin);
 }
 
-SyntaxAnalyzer::ParseStatus SyntaxAnalyzer::parse(const std::string& expr) {
-    std::istringstream expr_stream(expr);
-
-    return parse(expr_stream);
+Parser::ParseStatus Parser::parse(const std::string& expr) {
+    return parse_view(expr);
 }
 
-SyntaxAnalyzer::ParseStatus SyntaxAnalyzer::parse_file(const std::string& path) {
-    std::ifstream file_stream(path);
-    if (!file_stream.is_open()) {
-        std::cerr << "Failed to open file '" << path << "'\n";
+Parser::ParseStatus Parser::parse_view(std::string_view expr) {
+    clear_result();
+    if (expr.size() > UINT32_MAX) {
+        std::cerr << "Input is too long: " << expr.size() << " bytes\n";
         return ParseStatus::BAD_INPUT;
     }
 
-    return parse(file_stream);
+    if (lexer_backend == LexerBackend::DIRECT) {
+        direct_lexer.restart(expr);
+        return parse_loop(direct_lexer);
+    }
+    if (lexer_backend == LexerBackend::TOKEN_BUFFER) {
+        token_buffer.clear(expr);
+        tables.tokenize(expr, token_buffer);
+        std::size_t pos = 0;
+        return parse_tokens(token_buffer, pos);
+    }
+
+    view_buf.reset(expr);
+    view_stream.clear();
+    lexer.restart(view_stream);
+
+    return parse_loop(lexer);
 }
 
-void SyntaxAnalyzer::print_parse_state(std::ostream& os, char delimeter) {
-    int cur_state = stateStack.back().first;
+void Parser::parse_batch(std::span<const std::string_view> exprs, BatchResult& results) {
+    results.status.clear();
+    results.roots.clear();
+    results.status.reserve(exprs.size());
+    results.roots.reserve(exprs.size());
+
+    for (std::string_view expr: exprs) {
+        results.status.push_back(parse_view(expr));
+        results.roots.push_back(std::move(root));
+        clear_result();
+    }
+}
+
+Parser::BatchResult Parser::parse_batch(std::span<const std::string_view> exprs) {
+    BatchResult results;
+    parse_batch(exprs, results);
+    return results;
+}
+
+Parser::ParseStatus Parser::parse_file(const std::string& path) {
+    SLR::InputFile file;
+    if (file.open(path)) return ParseStatus::BAD_INPUT;
 
-    const Token& buf_tok = lexer.cur_tok();
+    // AST doesn't refer to the input, so the file is unmapped right after parsing
+    return parse_view(file.view());
+}
 
-    ActionEntry entry = action_goto[cur_state][token_to_symbol(buf_tok)];
+void Parser::print_parse_state(std::ostream& os, ActionEntry entry, const Token& buf_tok, std::string_view source,
+                               char delimeter) {
+    int cur_state = stateStack.back().first;
 
     os << cur_state  << " " << delimeter << " ";
     for (auto [state, s]: stateStack) {
-        os << s << " ";
+        os << tables.symbol_name(s) << " ";
     }
 
-    os << " " << delimeter << " " << buf_tok.lexeme_ << " " << delimeter << " ";
+    os << " " << delimeter << " " << buf_tok.lexeme(source) << " " << delimeter << " ";
 
-    print_action(os, entry);
+    tables.print_action(os, entry);
 
-    if (entry.type == REDUCE) os << " " << Item{entry.val, -1};
+    if (entry.type == SLR::REDUCE) tables.print_item(os << " ", ParseTables::Item{entry.val, -1});
     os << "\n";
 }
 
 
-SyntaxAnalyzer::ParseStatus SyntaxAnalyzer::parse(std::istream& in) {
-    root = nullptr;
+Parser::ParseStatus Parser::parse(std::istream& in) {
+    clear_result();
     // initializing lexer
     lexer.restart(in);
 
-    std::vector<std::variant<Token, AST::NodePtr>> ast;
+    return parse_loop(lexer);
+}
 
-    stateStack.clear();
-    stateStack.push_back({0, EPS});
+template <TokenSource Lexer>
+Parser::ParseStatus Parser::parse_loop(Lexer& lex) {
+    push_active = false; // stacks are taken over
+    if (!tables.action_table) {
+        std::cerr << "Parser tables are not initialized\n";
+        return ParseStatus::FATAL_ERR;
+    }
 
-    Token tok = lexer.next_tok();
+    if (tables.use_compressed) return parse_loop(tables.compressed_tables, lex);
+    return parse_loop(SLR::DenseTables{tables.action_table, tables.numSymbols}, lex);
+}
+
+template <typename Tables, TokenSource Lexer>
+Parser::ParseStatus Parser::parse_loop(const Tables& layout, Lexer& lex) {
+    start_stacks();
 
     while (true) {
+        const Token& tok = lex.next_tok();
+        ParseStatus status = push_token(layout, tok, Symbol(tok.symbol_), lex.source());
+        if (status != ParseStatus::INCOMPLETE) return status;
+    }
+}
 
-        if (parse_log_stream)
-            print_parse_state(*parse_log_stream);
+void Parser::start_stacks() {
+    valueStack.clear();
+    stateStack.clear();
+    stateStack.push_back({0, ParseTables::EPS});
+    token_count = 0;
+}
 
-        if (tok.type_ == TokenType::UNKNOWN) {
-            std::cout << "Lexical error: " << tok.lexeme_ << "\n";
-            return ParseStatus::LEXICAL_ERR;
+template <typename Tables>
+Parser::ParseStatus Parser::push_token(const Tables& layout, const Token& tok, Symbol s, std::string_view source) {
+    ValueStack& ast = valueStack;
+
+    if (s == ParseTables::LEX_ERROR) {
+        if (parse_log_stream)
+            print_parse_state(*parse_log_stream, ActionEntry{}, tok, source);
+        if (tok.too_long) {
+            if (error_stream) *error_stream << "Input is too long: more than " << UINT32_MAX << " bytes of tokens\n";
+            return ParseStatus::BAD_INPUT;
         }
+        if (error_stream) {
+            if (tok.out_of_range) *error_stream << "Lexical error: number out of range: ";
+            else *error_stream << "Lexical error: ";
+            *error_stream << tok.lexeme(source) << "\n";
+        }
+        return ParseStatus::LEXICAL_ERR;
+    }
+
+    if (++token_count > limits.max_tokens) {
+        if (error_stream) *error_stream << "Expression is too long: more than " << limits.max_tokens << " tokens\n";
+        return ParseStatus::BAD_INPUT;
+    }
+
+    // reducing until tok is shifted
+    while (true) {
 
         auto top = stateStack.back();
         int cur_state = top.first;
-        Symbol s = token_to_symbol(tok);
-        ActionEntry entry = action_goto[cur_state][s];
+        ActionEntry entry = layout.action(cur_state, s);
+
+        if (parse_log_stream)
+            print_parse_state(*parse_log_stream, entry, tok, source);
 
         switch (entry.type) {
-            case ERROR:
+            case SLR::ERROR:
             {
-                report_error(cur_state, tok);
+                report_error(cur_state, tok, source);
                 return ParseStatus::SYNTAX_ERR;
             }
-            case SHIFT:
+            case SLR::SHIFT:
             {
+                if (stateStack.size() >= limits.max_depth) {
+                    report_depth(tok);
+                    return ParseStatus::BAD_INPUT;
+                }
                 stateStack.push_back({entry.val, s});
                 ast.push_back(tok);
-
-                tok = lexer.next_tok();
             }
-                break;
-            case REDUCE:
+                return ParseStatus::INCOMPLETE;
+            case SLR::REDUCE:
             {
-                const Production& prod = grammar[entry.val];
-
-                if (prod.reduce) {
-                    prod.reduce(ast);
+                const ParseTables::ReduceInfo& prod = tables.reduce_table[entry.val];
+                Symbol lhs = Symbol(prod.lhs);
+
+                if (reduceFunc *reduce = tables.reducer_table[entry.val]) {
+                    reduce(ast, ReduceContext{source, symbol_cache,
+                                              ast_storage == AstStorage::ARENA ? &tree : nullptr,
+                                              ast_storage == AstStorage::POSTFIX ? &postfix : nullptr,
+                                              ast_storage == AstStorage::DAG ? &dag : nullptr});
+                } else if (prod.rhs_len != 1) {
+                    // no action: keep value stack in sync with state stack
+                    ast.erase(ast.end()-prod.rhs_len, ast.end());
+                    ast.push_back(AST::NodePtr{});
                 }
 
-                stateStack.erase(stateStack.end()-prod.rhs.size(), stateStack.end());
-                int new_state = action_goto[stateStack.back().first][prod.lhs].val;
+                stateStack.erase(stateStack.end()-prod.rhs_len, stateStack.end());
+                if (stateStack.size() >= limits.max_depth) { // only empty productions grow the stack
+                    report_depth(tok);
+                    return ParseStatus::BAD_INPUT;
+                }
+                int new_state = layout.goto_state(stateStack.back().first, lhs);
 
-                stateStack.push_back({new_state, prod.lhs});
+                stateStack.push_back({new_state, lhs});
             }
                 break;
-            case ACCEPT:
+            case SLR::ACCEPT:
                 // std::cout << "Parsing complete\n";
-                root = std::get<AST::NodePtr>(ast.front());
+                if (auto node = std::get_if<AST::NodePtr>(&ast.front()))
+                    root = std::move(*node);
+                else if (auto index = std::get_if<AST::NodeIndex>(&ast.front())) {
+                    if (ast_storage == AstStorage::ARENA) tree.root = *index;
+                    else postfix_end = postfix.size();
+                }
+                ast.clear(); // keeps capacity for the next parse
                 return ParseStatus::SUCCESS;
-            case GOTO:
+            case SLR::GOTO:
             default: std::cerr << "UNKNOWN ENTRY TYPE\n";
                 return ParseStatus::FATAL_ERR;
             break;
@@ -567,3 +1097,90 @@ SyntaxAnalyzer::ParseStatus SyntaxAnalyzer::parse(std::istream& in) {
 
     return ParseStatus::FATAL_ERR;
 }
+
+/* =============================== Token buffer ============================ */
+void ParseTables::tokenize(std::string_view expr, TokenBuffer& out) const {
+    std::uint32_t base = expr.data() - out.source.data();
+
+    DirectLexer lexer;
+    lexer.set_symbol_map(grammar.tokens);
+    lexer.restart(expr);
+    do {
+        out.push_back(lexer.next_tok(), base);
+    } while (out.types.back() != TokenType::END);
+}
+
+Parser::ParseStatus Parser::parse_tokens(const TokenBuffer& tokens, std::size_t& pos) {
+    push_active = false; // stacks are taken over
+    clear_result();
+    if (!tables.action_table) {
+        std::cerr << "Parser tables are not initialized\n";
+        return ParseStatus::FATAL_ERR;
+    }
+
+    if (tables.use_compressed) return parse_tokens(tables.compressed_tables, tokens, pos);
+    return parse_tokens(SLR::DenseTables{tables.action_table, tables.numSymbols}, tokens, pos);
+}
+
+template <typename Tables>
+Parser::ParseStatus Parser::parse_tokens(const Tables& layout, const TokenBuffer& tokens, std::size_t& pos) {
+    start_stacks();
+
+    ParseStatus status;
+    do {
+        status = push_token(layout, tokens.token(pos), Symbol(tokens.symbols[pos]), tokens.source);
+    } while (status == ParseStatus::INCOMPLETE && tokens.types[pos++] != TokenType::END);
+
+    // skipping the rest of the expression after an error
+    while (pos < tokens.size() && tokens.types[pos++] != TokenType::END) {}
+    return status;
+}
+
+/* =============================== Push parsing ============================ */
+Parser::ParseStatus Parser::feed(std::string_view bytes) {
+    if (!push_active) start_push();
+    if (push_status != ParseStatus::INCOMPLETE) return push_status;
+
+    push_lexer.feed(bytes);
+    push_status = push_tokens();
+    return push_status;
+}
+
+Parser::ParseStatus Parser::finish() {
+    if (!push_active) start_push();
+    if (push_status == ParseStatus::INCOMPLETE) {
+        push_lexer.finish();
+        push_status = push_tokens();
+    }
+
+    push_active = false;
+    return push_status;
+}
+
+void Parser::start_push() {
+    clear_result();
+    push_active = true;
+    push_lexer.restart();
+    start_stacks();
+
+    push_status = ParseStatus::INCOMPLETE;
+    if (!tables.action_table) {
+        std::cerr << "Parser tables are not initialized\n";
+        push_status = ParseStatus::FATAL_ERR;
+    }
+}
+
+Parser::ParseStatus Parser::push_tokens() {
+    if (tables.use_compressed) return push_tokens(tables.compressed_tables);
+    return push_tokens(SLR::DenseTables{tables.action_table, tables.numSymbols});
+}
+
+template <typename Tables>
+Parser::ParseStatus Parser::push_tokens(const Tables& layout) {
+    while (push_lexer.next_tok()) {
+        const Token& tok = push_lexer.cur_tok();
+        ParseStatus status = push_token(layout, tok, Symbol(tok.symbol_), push_lexer.source());
+        if (status != ParseStatus::INCOMPLETE) return status;
+    }
+    return ParseStatus::INCOMPLETE;
+}
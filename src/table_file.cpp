@@ -0,0 +1,131 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "table_file.hpp"
+
+namespace SLR {
+
+    static std::size_t align8(std::size_t offset) {
+        return (offset + 7) & ~std::size_t(7);
+    }
+
+    int write_table_file(const std::string& path,
+                         std::size_t n_states, std::size_t n_symbols, const ActionEntry *actions,
+                         std::size_t n_productions, const ReduceInfo *prods,
+                         const std::vector<std::string>& symbol_names) {
+        if (symbol_names.size() != n_symbols) {
+            std::cerr << "Symbol names don't match symbol count\n";
+            return -1;
+        }
+
+        TableFileHeader header{};
+        std::memcpy(header.magic, table_file_magic, sizeof(header.magic));
+        header.version = table_file_version;
+        header.byte_order = table_file_byte_order;
+        header.n_states = n_states;
+        header.n_symbols = n_symbols;
+        header.n_productions = n_productions;
+
+        std::size_t actions_size = n_states * n_symbols * sizeof(ActionEntry);
+        std::size_t prods_size = n_productions * sizeof(ReduceInfo);
+
+        std::vector<std::uint32_t> name_offsets;
+        std::string names_pool;
+        std::size_t names_start = n_symbols * sizeof(std::uint32_t);
+        for (const std::string& name: symbol_names) {
+            name_offsets.push_back(names_start + names_pool.size());
+            names_pool += name;
+            names_pool += '\0';
+        }
+
+        header.actions_offset = align8(sizeof(TableFileHeader));
+        header.prods_offset = align8(header.actions_offset + actions_size);
+        header.names_offset = align8(header.prods_offset + prods_size);
+        header.file_size = header.names_offset + names_start + names_pool.size();
+
+        std::vector<char> image(header.file_size, '\0');
+        std::memcpy(image.data(), &header, sizeof(header));
+        std::memcpy(image.data() + header.actions_offset, actions, actions_size);
+        std::memcpy(image.data() + header.prods_offset, prods, prods_size);
+        std::memcpy(image.data() + header.names_offset, name_offsets.data(), names_start);
+        std::memcpy(image.data() + header.names_offset + names_start, names_pool.data(), names_pool.size());
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out.good()) {
+            std::cerr << "Failed to open file '" << path << "'\n";
+            return -1;
+        }
+        out.write(image.data(), image.size());
+
+        return out.good() ? 0 : -1;
+    }
+
+
+    MappedTableFile::~MappedTableFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    int MappedTableFile::open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open file '" << path << "'\n";
+            return -1;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(TableFileHeader)) {
+            std::cerr << "Table file '" << path << "' is too small\n";
+            close(fd);
+            return -1;
+        }
+
+        void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Failed to map file '" << path << "'\n";
+            return -1;
+        }
+        data_ = static_cast<const char*>(mapped);
+        size_ = st.st_size;
+
+        const TableFileHeader& h = header();
+        auto section_fits = [&](std::uint32_t offset, std::size_t size) {
+            return offset % 8 == 0 && offset <= size_ && size <= size_ - offset;
+        };
+
+        bool valid = std::memcmp(h.magic, table_file_magic, sizeof(h.magic)) == 0
+            && h.version == table_file_version
+            && h.byte_order == table_file_byte_order
+            && h.file_size == size_
+            && data_[size_ - 1] == '\0' // names are NUL-terminated
+            && section_fits(h.actions_offset, std::size_t(h.n_states) * h.n_symbols * sizeof(ActionEntry))
+            && section_fits(h.prods_offset, std::size_t(h.n_productions) * sizeof(ReduceInfo))
+            && section_fits(h.names_offset, std::size_t(h.n_symbols) * sizeof(std::uint32_t));
+
+        if (!valid) {
+            std::cerr << "'" << path << "' is not a table file of version " << table_file_version << "\n";
+            munmap(mapped, size_);
+            data_ = nullptr;
+            return -1;
+        }
+
+        return 0;
+    }
+
+    const char *MappedTableFile::symbol_name(std::size_t sym) const {
+        const TableFileHeader& h = header();
+        if (sym >= h.n_symbols) return nullptr;
+
+        const char *names = data_ + h.names_offset;
+        std::uint32_t offset = reinterpret_cast<const std::uint32_t*>(names)[sym];
+        if (h.names_offset + offset >= size_) return nullptr;
+
+        return names + offset;
+    }
+};
@@ -0,0 +1,70 @@
+#include <unordered_map>
+
+#include "table_layout.hpp"
+
+namespace SLR {
+
+    // most frequent value among cells, cells must not be empty
+    template <typename V, typename Key>
+    static V most_frequent(const std::vector<std::pair<int, V>>& cells, Key key) {
+        std::unordered_map<int, int> counts;
+        V best = cells.front().second;
+        int best_count = 0;
+        for (const auto& [col, v]: cells) {
+            int count = ++counts[key(v)];
+            if (count > best_count) {
+                best = v;
+                best_count = count;
+            }
+        }
+        return best;
+    }
+
+    CompressedTables compress_tables(const ActionEntry *cells, std::size_t n_states, std::size_t n_symbols,
+                                     const std::vector<std::uint8_t>& is_term) {
+        CompressedTables result;
+
+        std::vector<std::vector<std::pair<int, ActionEntry>>> action_rows(n_states);
+        std::vector<std::vector<std::pair<int, std::int16_t>>> goto_cols(n_symbols);
+
+        result.default_reduce.assign(n_states, -1);
+        for (std::size_t state = 0; state < n_states; state++) {
+            std::vector<std::pair<int, ActionEntry>> reductions;
+            for (std::size_t sym = 0; sym < n_symbols; sym++) {
+                const ActionEntry& entry = cells[state * n_symbols + sym];
+                if (entry.type == ERROR) continue;
+
+                if (!is_term[sym]) {
+                    goto_cols[sym].push_back({int(state), entry.val});
+                } else if (entry.type == REDUCE) {
+                    reductions.push_back({int(sym), entry});
+                } else {
+                    action_rows[state].push_back({int(sym), entry});
+                }
+            }
+            if (reductions.empty()) continue;
+
+            // all reductions but the default one stay in the row
+            auto prod_id = [](const ActionEntry& entry) { return int(entry.val); };
+            std::int16_t default_prod = most_frequent(reductions, prod_id).val;
+            result.default_reduce[state] = default_prod;
+            for (const auto& cell: reductions) {
+                if (cell.second.val != default_prod) action_rows[state].push_back(cell);
+            }
+        }
+
+        result.default_goto.assign(n_symbols, -1);
+        for (std::size_t sym = 0; sym < n_symbols; sym++) {
+            std::vector<std::pair<int, std::int16_t>>& col = goto_cols[sym];
+            if (col.empty()) continue;
+
+            std::int16_t target = most_frequent(col, [](std::int16_t t) { return int(t); });
+            result.default_goto[sym] = target;
+            std::erase_if(col, [&](const auto& cell) { return cell.second == target; });
+        }
+
+        result.actions.pack(action_rows, n_symbols);
+        result.gotos.pack(goto_cols, n_states);
+        return result;
+    }
+};
@@ -1,7 +1,23 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 #include <utility>
+#include <sys/stat.h>
 #include "AST.hpp"
+#include "ast_binary.hpp"
+#include "ast_writer.hpp"
+#include "ast_vm.hpp"
+#include "bitset.hpp"
+#include "direct_lexer.hpp"
+#include "input_file.hpp"
+#include "parallel_parser.hpp"
 #include "syntax_analyzer.hpp"
 
 
@@ -11,6 +27,126 @@ TEST(ParserInterface, Init) {
     EXPECT_EQ(0, parser.init());
 };
 
+TEST(ParserInterface, RuntimeInit) {
+    SyntaxAnalyzer parser;
+
+    EXPECT_EQ(0, parser.init(SyntaxAnalyzer::TableSource::RUNTIME));
+
+    EXPECT_EQ(SyntaxAnalyzer::ParseStatus::SUCCESS, parser.parse("(1+x)*y-4/z"));
+    std::ostringstream out;
+    AST::dumpTreeAsString(parser.get_root(), out);
+    EXPECT_EQ("(BINOP:-(BINOP:*(BINOP:+(NUM:1)(ID:x))(ID:y))(BINOP:/(NUM:4)(ID:z)))", out.str());
+};
+
+TEST(ParserInterface, CompiledTablesMatchRuntime) {
+    // the exported file holds every action/goto cell and every reduce entry
+    auto export_tables = [](SyntaxAnalyzer::TableSource source) {
+        const std::string path = "test_tables_source.bin";
+        SyntaxAnalyzer parser;
+        EXPECT_EQ(0, parser.init(source));
+        EXPECT_EQ(0, parser.export_binary_tables(path));
+        std::ifstream in(path, std::ios::binary);
+        std::string image(std::istreambuf_iterator<char>(in), {});
+        in.close();
+        std::filesystem::remove(path);
+        return std::pair(parser.table_stats().states, image);
+    };
+
+    auto [compiled_states, compiled] = export_tables(SyntaxAnalyzer::TableSource::COMPILED);
+    auto [runtime_states, runtime] = export_tables(SyntaxAnalyzer::TableSource::RUNTIME);
+    EXPECT_EQ(runtime_states, compiled_states);
+    ASSERT_EQ(runtime.size(), compiled.size());
+
+    SLR::TableFileHeader header;
+    std::memcpy(&header, runtime.data(), sizeof(header));
+    for (std::size_t i = 0; i < std::size_t(header.n_states) * header.n_symbols; i++) {
+        SLR::ActionEntry expected, actual;
+        std::memcpy(&expected, runtime.data() + header.actions_offset + i * sizeof(expected), sizeof(expected));
+        std::memcpy(&actual, compiled.data() + header.actions_offset + i * sizeof(actual), sizeof(actual));
+        EXPECT_EQ(expected.type, actual.type) << "state " << i / header.n_symbols << " symbol " << i % header.n_symbols;
+        EXPECT_EQ(expected.val, actual.val) << "state " << i / header.n_symbols << " symbol " << i % header.n_symbols;
+    }
+    EXPECT_EQ(runtime, compiled);
+}
+
+TEST(ParserInterface, BinaryTables) {
+    const std::string path = "test_tables.bin";
+    {
+        SyntaxAnalyzer builder;
+        ASSERT_EQ(0, builder.init(SyntaxAnalyzer::TableSource::RUNTIME));
+        ASSERT_EQ(0, builder.export_binary_tables(path));
+    }
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init_from_file(path));
+
+    EXPECT_EQ(SyntaxAnalyzer::ParseStatus::SUCCESS, parser.parse("a*(b+4)"));
+    std::ostringstream out;
+    AST::dumpTreeAsString(parser.get_root(), out);
+    EXPECT_EQ("(BINOP:*(ID:a)(BINOP:+(ID:b)(NUM:4)))", out.str());
+    EXPECT_EQ(SyntaxAnalyzer::ParseStatus::SYNTAX_ERR, parser.parse("a*(b+4"));
+
+    // cells pointing outside the tables or not fitting their column must be rejected
+    std::string image;
+    {
+        std::ifstream in(path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    SLR::TableFileHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    auto load_modified = [&](auto modify) {
+        std::string copy = image;
+        modify(copy);
+        const std::string broken_path = "test_tables_broken.bin";
+        std::ofstream(broken_path, std::ios::binary) << copy;
+        SyntaxAnalyzer broken;
+        int error = broken.init_from_file(broken_path);
+        std::filesystem::remove(broken_path);
+        return error;
+    };
+    auto set_cell = [&](std::size_t cell, SLR::ActionEntry entry) {
+        return [=](std::string& copy) {
+            std::memcpy(copy.data() + header.actions_offset + cell * sizeof(entry), &entry, sizeof(entry));
+        };
+    };
+    std::streambuf *old_err = std::cerr.rdbuf(nullptr);
+    EXPECT_EQ(0, load_modified([](std::string&) {}));
+    EXPECT_NE(0, load_modified(set_cell(0, {SLR::SHIFT, int(header.n_states)})));
+    EXPECT_NE(0, load_modified(set_cell(1, {SLR::GOTO, -2})));
+    EXPECT_NE(0, load_modified(set_cell(header.n_symbols + 2, {SLR::REDUCE, int(header.n_productions)})));
+    EXPECT_NE(0, load_modified(set_cell(3, {SLR::ActionType(7), 0})));
+    EXPECT_NE(0, load_modified(set_cell(ParseTables::E, {SLR::SHIFT, 1})));
+    EXPECT_NE(0, load_modified(set_cell(ParseTables::NUM, {SLR::GOTO, 1})));
+    EXPECT_NE(0, load_modified(set_cell(ParseTables::EPS, {SLR::REDUCE, 1})));
+    EXPECT_NE(0, load_modified([&](std::string& copy) {
+        // T is reduced to, but there is nowhere to go after it
+        for (std::size_t state = 0; state < header.n_states; state++) {
+            set_cell(state * header.n_symbols + ParseTables::T, {})(copy);
+        }
+    }));
+    // same shape, other terminals
+    EXPECT_NE(0, load_modified([&](std::string& copy) {
+        std::uint32_t name_offset;
+        std::memcpy(&name_offset, copy.data() + header.names_offset + ParseTables::PLUS * sizeof(name_offset),
+                    sizeof(name_offset));
+        copy[header.names_offset + name_offset] = '^';
+    }));
+    EXPECT_NE(0, load_modified([&](std::string& copy) {
+        SLR::TableFileHeader empty = header;
+        empty.n_states = 0;
+        std::memcpy(copy.data(), &empty, sizeof(empty));
+    }));
+    std::cerr.rdbuf(old_err);
+
+    // truncated file must be rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    SyntaxAnalyzer broken;
+    EXPECT_NE(0, broken.init_from_file(path));
+    EXPECT_NE(0, broken.init_from_file("no_such_tables.bin"));
+
+    std::filesystem::remove(path);
+};
+
 using SerializedAST = std::string;
 using ParseStatus = SyntaxAnalyzer::ParseStatus;
 
@@ -102,6 +238,9 @@ TEST_F(ParserTest, LexerTests) {
         {"1234567890", "(NUM:1234567890)"},
         {"0", "(NUM:0)"},
         {"0123", "(NUM:123)"}, // numbers starting with leading zero are accepted
+        {"2147483647", "(NUM:2147483647)"},
+        {"2147483648", "<EMPTY_TREE>", ParseStatus::LEXICAL_ERR}, // doesn't fit into int
+        {"x+00000000000000000000000000000000000000000000000000000000000042", "(BINOP:+(ID:x)(NUM:42))"},
         {"var_1", "<EMPTY_TREE>", ParseStatus::LEXICAL_ERR},
         {"3^9", "<EMPTY_TREE>", ParseStatus::LEXICAL_ERR},
         {"xy~4", "<EMPTY_TREE>", ParseStatus::LEXICAL_ERR},
@@ -150,6 +289,1640 @@ TEST_F(ParserTest, SyntaxErrors) {
     }
 }
 
+/* ======================== BITSETS ========================== */
+
+static std::vector<std::size_t> bits_of(const SLR::Bitset& set) {
+    std::vector<std::size_t> bits;
+    set.for_each([&](std::size_t i) { bits.push_back(i); });
+    return bits;
+}
+
+TEST(Bitset, SetOperations) {
+    // sizes that are and aren't whole words
+    for (std::size_t size: {1, 63, 64, 65, 200}) {
+        SLR::Bitset a(size), b(size);
+        EXPECT_FALSE(a.any());
+        EXPECT_EQ(0, a.count());
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(a.hash(), b.hash());
+
+        // for_each is ascending across word boundaries
+        std::vector<std::size_t> expected;
+        for (std::size_t i: {std::size_t(0), size / 2, size - 1, std::size_t(63), std::size_t(64)}) {
+            if (i >= size || std::find(expected.begin(), expected.end(), i) != expected.end()) continue;
+            a.set(i);
+            expected.push_back(i);
+        }
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(expected, bits_of(a)) << size;
+        EXPECT_EQ(expected.size(), a.count()) << size;
+        EXPECT_TRUE(a.test(size - 1)) << size;
+        EXPECT_NE(a, b) << size;
+
+        // union reports whether anything was added
+        EXPECT_TRUE(b.merge(a)) << size;
+        EXPECT_FALSE(b.merge(a)) << size;
+        EXPECT_EQ(a, b) << size;
+        EXPECT_EQ(a.hash(), b.hash()) << size;
+
+        SLR::Bitset c(size);
+        c.set(size - 1);
+        EXPECT_FALSE(b.merge(c)) << size;
+        EXPECT_EQ(expected.size() > 1, c.merge(a)) << size; // a has more bits than the last one
+        EXPECT_EQ(a, c) << size;
+
+        a.reset(size - 1);
+        EXPECT_FALSE(a.test(size - 1)) << size;
+        EXPECT_NE(a, b) << size;
+        EXPECT_EQ(expected.size() - 1, a.count()) << size;
+
+        b.clear();
+        EXPECT_FALSE(b.any()) << size;
+        EXPECT_TRUE(bits_of(b).empty()) << size;
+    }
+
+    // sets are found by content in hashed containers, as LR(0) kernels are
+    std::unordered_set<SLR::Bitset, SLR::Bitset::Hash> kernels;
+    SLR::Bitset x(130), y(130);
+    x.set(129);
+    y.set(129);
+    kernels.insert(x);
+    EXPECT_TRUE(kernels.contains(y));
+    y.set(3);
+    EXPECT_FALSE(kernels.contains(y));
+}
+
+/* ======================== GRAMMAR LOADING ========================== */
+
+static std::string serialize(SyntaxAnalyzer& parser) {
+    std::ostringstream out;
+    AST::dumpTreeAsString(parser.get_root(), out);
+    return out.str();
+}
+
+TEST(GrammarLoading, BuiltinGrammarFromBNF) {
+    std::istringstream bnf(R"(
+        # same language as the built-in grammar
+        E -> E '+' T @binop | E '-' T @binop | T ;
+        T -> T '*' F @binop | T '/' F @binop | F ;
+        F -> '(' E ')' @paren | id @numid | num @numid ;
+    )");
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.load_grammar(bnf));
+    ASSERT_EQ(0, parser.init(SyntaxAnalyzer::TableSource::RUNTIME));
+
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse("1-x/y*2+4"));
+    EXPECT_EQ("(BINOP:+(BINOP:-(NUM:1)(BINOP:*(BINOP:/(ID:x)(ID:y))(NUM:2)))(NUM:4))", serialize(parser));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse("1+()"));
+
+    // compiled tables belong to the built-in grammar only
+    EXPECT_EQ(-1, parser.init(SyntaxAnalyzer::TableSource::COMPILED));
+}
+
+static void reduceNeg(ValueStack& ast, const ReduceContext&) {
+    AST::NodePtr value = std::get<AST::NodePtr>(ast.back());
+    ast.pop_back();
+    ast.pop_back(); // 'neg' keyword
+
+    ast.push_back(AST::makeBinOp(AST::makeNum(0), AST::MINUS, value));
+}
+
+TEST(GrammarLoading, KeywordsAndCustomActions) {
+    std::istringstream bnf(R"(
+        S -> 'neg' E @neg | E ;
+        E -> E '+' T @binop | T ;
+        T -> id @numid | num @numid | '(' E ')' @paren ;
+    )");
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.load_grammar(bnf));
+    // '@neg' is not bound yet
+    EXPECT_EQ(-1, parser.init(SyntaxAnalyzer::TableSource::RUNTIME));
+
+    parser.bind_action("neg", reduceNeg);
+    ASSERT_EQ(0, parser.init(SyntaxAnalyzer::TableSource::RUNTIME));
+
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse("neg (x+1)"));
+    EXPECT_EQ("(BINOP:-(NUM:0)(BINOP:+(ID:x)(NUM:1)))", serialize(parser));
+
+    // 'neg' is a keyword, not an identifier; '*' is not in the grammar
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse("neg"));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse("x*2"));
+
+    // binary nodes exist for + - * / only
+    for (std::string rule: {"E -> E '^' T @binop | T ;", "E -> E 'and' T @binop | T ;", "E -> '+' T @binop | T ;"}) {
+        std::istringstream in(rule + " T -> id @numid ;");
+        SyntaxAnalyzer other;
+        ASSERT_EQ(0, other.load_grammar(in)) << rule;
+        std::streambuf *old_err = std::cerr.rdbuf(nullptr);
+        EXPECT_EQ(-1, other.init(SyntaxAnalyzer::TableSource::RUNTIME)) << rule;
+        std::cerr.rdbuf(old_err);
+    }
+}
+
+TEST(GrammarLoading, Errors) {
+    std::vector<std::string> bad_grammars = {
+        "",
+        "E -> ;",
+        "E -> expr ;",             // unknown token class
+        "E -> '+=' ;",             // multi-char operator
+        "E -> 'x1' ;",             // keyword the lexers read as an identifier and a number
+        "E -> 'do_it' ;",
+        "E -> '7' ;",              // digit, blank or control character as an operator
+        "E -> ' ' ;",
+        "E -> '\t' ;",
+        "E -> id @a @b ;",
+        "E -> id",                 // missing ';'
+    };
+
+    for (const std::string& text: bad_grammars) {
+        std::istringstream bnf(text);
+        SyntaxAnalyzer parser;
+        EXPECT_EQ(-1, parser.load_grammar(bnf)) << text;
+    }
+}
+
+static void reducePair(ValueStack& ast, const ReduceContext& ctx) {
+    reduceNumId(ast, ctx);
+    ast.erase(ast.end() - 2); // keyword
+}
+
+// identifiers are letters only, so i is spelled in base 26
+static std::string keyword(int i) {
+    std::string name = "kw";
+    for (; i; i /= 26) name += char('a' + i % 26);
+    return name;
+}
+
+// S -> X0 | X1 | ... ; Xi -> 'kwi' id | 'kwi' num
+static std::string keyword_grammar(int n) {
+    std::ostringstream bnf;
+    bnf << "S -> X0";
+    for (int i = 1; i < n; i++) bnf << " | X" << i;
+    bnf << " ;\n";
+    for (int i = 0; i < n; i++) {
+        bnf << "X" << i << " -> '" << keyword(i) << "' id @pair | '" << keyword(i) << "' num @pair ;\n";
+    }
+    return bnf.str();
+}
+
+TEST(GrammarLoading, LargeGrammar) {
+    std::istringstream in(keyword_grammar(500));
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.load_grammar(in));
+    parser.bind_action("pair", reducePair);
+    EXPECT_EQ(0, parser.init(SyntaxAnalyzer::TableSource::RUNTIME));
+
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse(keyword(321) + " x"));
+    EXPECT_EQ("(ID:x)", serialize(parser));
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse(keyword(499) + " 17"));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse(keyword(12) + " " + keyword(13)));
+}
+
+/* ======================== LALR(1) TABLES ========================== */
+
+using Lookahead = SyntaxAnalyzer::Lookahead;
+
+TEST(LALRTables, BuiltinGrammar) {
+    SyntaxAnalyzer slr, lalr;
+    ASSERT_EQ(0, slr.init(SyntaxAnalyzer::TableSource::RUNTIME));
+    ASSERT_EQ(0, lalr.init(SyntaxAnalyzer::TableSource::RUNTIME, Lookahead::LALR));
+    EXPECT_EQ(slr.table_stats().states, lalr.table_stats().states);
+
+    for (std::string expr: {"1-x/y*2+4", "(a)", "((b+c)*2", "x*/y", "2+"}) {
+        EXPECT_EQ(slr.parse(expr), lalr.parse(expr)) << expr;
+        EXPECT_EQ(serialize(slr), serialize(lalr)) << expr;
+    }
+
+    // compiled tables are SLR(1)
+    EXPECT_EQ(-1, lalr.init(SyntaxAnalyzer::TableSource::COMPILED, Lookahead::LALR));
+}
+
+TEST(LALRTables, NotSLRGrammar) {
+    // classic assignment grammar
+    const std::string bnf = R"(
+        S -> L '=' R | R ;
+        L -> '*' R | id ;
+        R -> L ;
+    )";
+
+    SyntaxAnalyzer slr, lalr;
+    std::istringstream slr_in(bnf), lalr_in(bnf);
+    ASSERT_EQ(0, slr.load_grammar(slr_in));
+    ASSERT_EQ(0, lalr.load_grammar(lalr_in));
+
+    EXPECT_EQ(1, slr.init(SyntaxAnalyzer::TableSource::RUNTIME));
+    EXPECT_EQ(1, slr.table_stats().shift_reduce);
+
+    ASSERT_EQ(0, lalr.init(SyntaxAnalyzer::TableSource::RUNTIME, Lookahead::LALR));
+    EXPECT_EQ(slr.table_stats().states, lalr.table_stats().states);
+    EXPECT_GT(lalr.table_stats().nonterm_transitions, 0);
+
+    // '=' is not a built-in operator, every lexer backend reads it from the grammar
+    using Backend = SyntaxAnalyzer::LexerBackend;
+    for (Backend backend: {Backend::FLEX, Backend::DIRECT, Backend::TOKEN_BUFFER}) {
+        lalr.set_lexer_backend(backend);
+        EXPECT_EQ(ParseStatus::SUCCESS, lalr.parse("**x = *y"));
+        EXPECT_EQ(ParseStatus::SUCCESS, lalr.parse("x"));
+        EXPECT_EQ(ParseStatus::SYNTAX_ERR, lalr.parse("x = y = z"));
+        EXPECT_EQ(ParseStatus::SYNTAX_ERR, lalr.parse("x ="));
+    }
+    EXPECT_EQ(ParseStatus::INCOMPLETE, lalr.feed("*x ="));
+    EXPECT_EQ(ParseStatus::INCOMPLETE, lalr.feed(" y"));
+    EXPECT_EQ(ParseStatus::SUCCESS, lalr.finish());
+}
+
+TEST(LALRTables, NullableSymbols) {
+    std::istringstream bnf(R"(
+        S -> A '(' S ')' | %empty ;
+        A -> '+' | %empty ;
+    )");
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.load_grammar(bnf));
+    ASSERT_EQ(0, parser.init(SyntaxAnalyzer::TableSource::RUNTIME, Lookahead::LALR));
+
+    for (std::string expr: {"", "()", "+()", "(+())", "+(())"}) {
+        EXPECT_EQ(ParseStatus::SUCCESS, parser.parse(expr)) << expr;
+    }
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse("(+)"));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse("++()"));
+}
+
+TEST(LALRTables, TooManyStates) {
+    // a state per position in the rule, more than the 16-bit cells can refer to
+    std::string bnf = "S -> ";
+    for (int i = 0; i < INT16_MAX + 10; i++) bnf += "'a' ";
+    bnf += ";";
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    std::istringstream in(bnf);
+    ASSERT_EQ(0, parser.load_grammar(in));
+    std::streambuf *old_err = std::cerr.rdbuf(nullptr);
+    EXPECT_EQ(-1, parser.init(SyntaxAnalyzer::TableSource::RUNTIME));
+    EXPECT_EQ(0, parser.table_stats().states);
+    EXPECT_EQ(ParseStatus::FATAL_ERR, parser.parse("a"));
+    std::cerr.rdbuf(old_err);
+}
+
+TEST(LALRTables, NotLALRGrammar) {
+    // LR(1), but merging states of 'c' gives reduce/reduce conflicts
+    std::istringstream bnf(R"(
+        S -> 'a' A 'd' | 'b' B 'd' | 'a' B 'e' | 'b' A 'e' ;
+        A -> 'c' ;
+        B -> 'c' ;
+    )");
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.load_grammar(bnf));
+    EXPECT_EQ(2, parser.init(SyntaxAnalyzer::TableSource::RUNTIME, Lookahead::LALR));
+    EXPECT_EQ(0, parser.table_stats().shift_reduce);
+    EXPECT_EQ(2, parser.table_stats().reduce_reduce);
+}
+
+/* ======================== COMPRESSED TABLES ======================== */
+
+using TableLayout = SyntaxAnalyzer::TableLayout;
+
+TEST(CompressedTables, SameResultsAsDense) {
+    SyntaxAnalyzer dense, compressed;
+    EXPECT_EQ(-1, compressed.set_table_layout(TableLayout::COMPRESSED));
+
+    ASSERT_EQ(0, dense.init());
+    ASSERT_EQ(0, compressed.init());
+    ASSERT_EQ(0, compressed.set_table_layout(TableLayout::COMPRESSED));
+
+    const auto& stats = compressed.table_stats();
+    EXPECT_GT(stats.compressed_bytes, 0);
+    EXPECT_LT(stats.compressed_bytes, stats.dense_bytes);
+
+    for (std::string expr: {"1+x*y/2+4", "(((x)))+(y/(43-x))", "a*b/c*d", "0123",
+                            "(x", "1+()", "x++3", "+4", "x y", "3^9", ")("}) {
+        EXPECT_EQ(dense.parse(expr), compressed.parse(expr)) << expr;
+        EXPECT_EQ(serialize(dense), serialize(compressed)) << expr;
+    }
+
+    ASSERT_EQ(0, compressed.set_table_layout(TableLayout::DENSE));
+    EXPECT_EQ(0, compressed.table_stats().compressed_bytes);
+    EXPECT_EQ(ParseStatus::SUCCESS, compressed.parse("(1)"));
+}
+
+TEST(CompressedTables, LargeGrammar) {
+    std::istringstream in(keyword_grammar(500));
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.load_grammar(in));
+    parser.bind_action("pair", reducePair);
+    ASSERT_EQ(0, parser.init(SyntaxAnalyzer::TableSource::RUNTIME, Lookahead::LALR));
+    ASSERT_EQ(0, parser.set_table_layout(TableLayout::COMPRESSED));
+
+    // table is almost all ERROR cells
+    const auto& stats = parser.table_stats();
+    EXPECT_LT(stats.compressed_bytes * 20, stats.dense_bytes);
+
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse(keyword(321) + " x"));
+    EXPECT_EQ("(ID:x)", serialize(parser));
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse(keyword(499) + " 17"));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse(keyword(12) + " " + keyword(13)));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse(keyword(12)));
+}
+
+/* ======================== BATCH PARSING ============================ */
+
+TEST(BatchParsing, MatchesSingleParse) {
+    SyntaxAnalyzer batch, single;
+    ASSERT_EQ(0, batch.init());
+    ASSERT_EQ(0, single.init());
+
+    std::string text = "1+x*y/2+4\n(x\nx=y+5\n(((x)))+(y/(43-x))\n\n0123";
+    std::vector<std::string_view> exprs;
+    for (std::size_t pos = 0, next; pos <= text.size(); pos = next + 1) {
+        next = std::min(text.find('\n', pos), text.size());
+        exprs.push_back(std::string_view(text).substr(pos, next - pos));
+    }
+
+    SyntaxAnalyzer::BatchResult results = batch.parse_batch(exprs);
+    ASSERT_EQ(exprs.size(), results.size());
+
+    for (std::size_t i = 0; i < exprs.size(); i++) {
+        std::string expr(exprs[i]);
+        EXPECT_EQ(single.parse(expr), results.status[i]) << expr;
+
+        std::ostringstream out;
+        AST::dumpTreeAsString(results.roots[i], out);
+        EXPECT_EQ(serialize(single), out.str()) << expr;
+    }
+    EXPECT_EQ(ParseStatus::LEXICAL_ERR, results.status[2]);
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, results.status[4]);
+}
+
+TEST(BatchParsing, ReusesResultStorage) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+
+    std::vector<std::string_view> first = {"1+2", "a*(b-c)", "x", "(7)"};
+    std::vector<std::string_view> second = {"y/3", "1+"};
+
+    SyntaxAnalyzer::BatchResult results;
+    parser.parse_batch(first, results);
+    const AST::NodePtr *roots = results.roots.data();
+
+    parser.parse_batch(second, results);
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(roots, results.roots.data());
+    EXPECT_EQ(ParseStatus::SUCCESS, results.status[0]);
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, results.status[1]);
+    EXPECT_EQ(nullptr, results.roots[1]);
+}
+
+/* ======================== SHARED TABLES ============================ */
+
+static void collect_ids(const AST::NodePtr& node, std::vector<std::size_t>& ids) {
+    if (!node) return;
+    ids.push_back(node->id);
+    if (node->kind == AST::NodeKind::BINOP) {
+        const auto& binop = static_cast<const AST::BinOpNode&>(*node);
+        collect_ids(binop.left, ids);
+        collect_ids(binop.right, ids);
+    }
+}
+
+TEST(SharedTables, ParsersInThreads) {
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    ASSERT_EQ(0, tables.set_table_layout(TableLayout::COMPRESSED));
+
+    const std::vector<std::string> exprs = {"1+x*y/2+4", "(((x)))+(y/(43-x))", "a*b/c*d", "x++3", "(x"};
+    std::vector<std::pair<ParseStatus, std::string>> expected;
+    {
+        Parser parser(tables);
+        for (const std::string& expr: exprs) {
+            ParseStatus status = parser.parse(expr);
+            std::ostringstream out;
+            AST::dumpTreeAsString(parser.get_root(), out);
+            expected.push_back({status, out.str()});
+        }
+    }
+
+    const int n_threads = 4, rounds = 200;
+    std::vector<std::vector<std::size_t>> ids(n_threads);
+    std::vector<int> mismatches(n_threads, 0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t] {
+            Parser parser(tables);
+            for (int round = 0; round < rounds; round++) {
+                for (std::size_t i = 0; i < exprs.size(); i++) {
+                    ParseStatus status = parser.parse(exprs[i]);
+                    std::ostringstream out;
+                    AST::dumpTreeAsString(parser.get_root(), out);
+                    if (status != expected[i].first || out.str() != expected[i].second) mismatches[t]++;
+                    collect_ids(parser.get_root(), ids[t]);
+                }
+            }
+        });
+    }
+    for (std::thread& thread: threads) thread.join();
+
+    std::unordered_set<std::size_t> unique;
+    std::size_t total = 0;
+    for (int t = 0; t < n_threads; t++) {
+        EXPECT_EQ(0, mismatches[t]) << "thread " << t;
+        unique.insert(ids[t].begin(), ids[t].end());
+        total += ids[t].size();
+    }
+    EXPECT_EQ(total, unique.size());
+}
+
+/* ======================== PARALLEL PARSING ========================= */
+
+TEST(ParallelParsing, LinesInInputOrder) {
+    const std::vector<std::string> samples = {"1+x*y/2+4", "(x", "a*b/c*d", "x=y", "", "(((x)))+(y/(43-x))"};
+    std::string text;
+    std::vector<std::string> lines;
+    for (int i = 0; i < 5000; i++) {
+        // distinct lines, so misplaced results are caught
+        lines.push_back(samples[i % samples.size()] + (i % 3 ? "+" + std::to_string(i) : ""));
+        text += lines.back() + (i % 7 ? "\n" : "\r\n");
+    }
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    LineResults results = parse_lines(tables, text, 4);
+    ASSERT_EQ(lines.size(), results.size());
+
+    Parser parser(tables);
+    parser.set_error_stream(nullptr);
+    for (std::size_t i = 0; i < lines.size(); i++) {
+        EXPECT_EQ(parser.parse(lines[i]), results.status[i]) << lines[i];
+
+        std::ostringstream out;
+        AST::dumpTreeAsString(parser.get_root(), out);
+        EXPECT_EQ(out.str(), results.serialized[i]) << lines[i];
+    }
+}
+
+TEST(ParallelParsing, LineSplitting) {
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+
+    EXPECT_EQ(0, parse_lines(tables, "", 2).size());
+
+    LineResults results = parse_lines(tables, "1+2\n\nx", 2);
+    ASSERT_EQ(3, results.size());
+    EXPECT_EQ(ParseStatus::SUCCESS, results.status[0]);
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, results.status[1]);
+    EXPECT_EQ("(ID:x)", results.serialized[2]);
+
+    LineResults missing;
+    EXPECT_EQ(-1, parse_file_lines(tables, "no_such_file.txt", missing));
+}
+
+// tokens with their lexemes
+template <typename Lexer>
+static std::vector<std::pair<Token, std::string>> lex_all(Lexer& lexer) {
+    std::vector<Token> tokens;
+    do tokens.push_back(lexer.next_tok()); while (tokens.back().type_ != TokenType::END);
+
+    std::vector<std::pair<Token, std::string>> result;
+    for (const Token& tok: tokens) result.emplace_back(tok, std::string(tok.lexeme(lexer.source())));
+    return result;
+}
+
+static std::vector<std::pair<Token, std::string>> lex_with_flex(const std::string& text) {
+    std::istringstream in(text);
+    mathLexer lexer;
+    lexer.restart(in);
+    return lex_all(lexer);
+}
+
+static std::vector<std::pair<Token, std::string>> lex_direct(std::string_view text) {
+    DirectLexer lexer;
+    lexer.restart(text);
+    return lex_all(lexer);
+}
+
+TEST(DirectLexer, SameTokensAsFlex) {
+    std::vector<std::string> inputs = {
+        "",
+        "   ",
+        "1+x*(y-42)/z",
+        " \t 12 \t+ ab\n\ncd*3 \n",
+        "x#y @ 7$",
+        // runs longer than one 16-byte block, ending inside and at the block boundary
+        std::string(40, 'a') + "+" + std::string(16, '7') + std::string(33, ' ') + "ZzYy" + std::string(20, '\t'),
+        "abcdefghijklmnopQRSTUVWXYZ[`{@0123456789:/" + std::string(17, '9'),
+    };
+
+    for (const std::string& text: inputs) {
+        auto expected = lex_with_flex(text);
+        auto tokens = lex_direct(text);
+
+        ASSERT_EQ(expected.size(), tokens.size()) << text;
+        for (std::size_t i = 0; i < tokens.size(); i++) {
+            EXPECT_EQ(expected[i].first.type_, tokens[i].first.type_) << text << " token " << i;
+            EXPECT_EQ(expected[i].second, tokens[i].second) << text << " token " << i;
+            EXPECT_EQ(expected[i].first.line_, tokens[i].first.line_) << text << " token " << i;
+            EXPECT_EQ(expected[i].first.pos_, tokens[i].first.pos_) << text << " token " << i;
+        }
+    }
+
+    // END is returned again after the end of input
+    DirectLexer lexer;
+    lexer.restart("x");
+    lexer.next_tok();
+    EXPECT_EQ(TokenType::END, lexer.next_tok().type_);
+    EXPECT_EQ(TokenType::END, lexer.next_tok().type_);
+}
+
+TEST(DirectLexer, ParserBackendsAgree) {
+    std::vector<std::string> inputs = {
+        "(1+x)*y-4/z", "a*(b+4", "1+()", "x#y", "12 ab", "\n 7\t*\n(q)", "", "x*99999999999",
+    };
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+
+    for (const std::string& text: inputs) {
+        std::ostringstream flex_errors, direct_errors;
+        Parser flex_parser(parser), direct_parser(parser);
+        flex_parser.set_lexer_backend(Parser::LexerBackend::FLEX);
+        flex_parser.set_error_stream(&flex_errors);
+        direct_parser.set_error_stream(&direct_errors);
+
+        EXPECT_EQ(flex_parser.parse(text), direct_parser.parse(text)) << text;
+        EXPECT_EQ(flex_errors.str(), direct_errors.str()) << text;
+        if (text == "x*99999999999") {
+            EXPECT_EQ("Lexical error: number out of range: 99999999999\n", direct_errors.str());
+        }
+
+        std::ostringstream flex_tree, direct_tree;
+        AST::dumpTreeAsString(flex_parser.get_root(), flex_tree);
+        AST::dumpTreeAsString(direct_parser.get_root(), direct_tree);
+        EXPECT_EQ(flex_tree.str(), direct_tree.str()) << text;
+    }
+}
+
+TEST(DirectLexer, SymbolCodes) {
+    SymbolMap map;
+    map.number = 3;
+    map.identifier = 4;
+    map.end = 9;
+    map.operators['+'] = 5;
+    map.keywords["neg"] = 6;
+    map.operators['='] = 7;
+
+    // '*' is not in the map, '=' is an operator only because it is, '#' is not a token at all
+    const std::string text = "neg x+12*99999999999 = #";
+    const std::vector<std::int32_t> expected = {6, 4, 5, 3, 0, SymbolMap::error_symbol, 7, SymbolMap::error_symbol, 9};
+
+    std::istringstream in(text);
+    mathLexer flex;
+    flex.set_symbol_map(map);
+    flex.restart(in);
+    DirectLexer direct;
+    direct.set_symbol_map(map);
+    direct.restart(text);
+    PushLexer push;
+    push.set_symbol_map(map);
+    push.restart();
+
+    std::vector<std::int32_t> flex_symbols, direct_symbols, push_symbols;
+    do flex_symbols.push_back(flex.next_tok().symbol_); while (flex.cur_tok().type_ != TokenType::END);
+    do direct_symbols.push_back(direct.next_tok().symbol_); while (direct.cur_tok().type_ != TokenType::END);
+    for (char c: text) {
+        push.feed(std::string_view(&c, 1));
+        while (push.next_tok()) push_symbols.push_back(push.cur_tok().symbol_);
+    }
+    push.finish();
+    ASSERT_TRUE(push.next_tok());
+    push_symbols.push_back(push.cur_tok().symbol_);
+
+    EXPECT_EQ(expected, flex_symbols);
+    EXPECT_EQ(expected, direct_symbols);
+    EXPECT_EQ(expected, push_symbols);
+
+    // unknown characters stop the parse as lexical errors, not as the end of input
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser parser(tables);
+    std::ostringstream errors;
+    parser.set_error_stream(&errors);
+    EXPECT_EQ(ParseStatus::LEXICAL_ERR, parser.parse_view("x#"));
+    EXPECT_EQ("Lexical error: #\n", errors.str());
+}
+
+/* ======================== FILE INPUT ========================== */
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+TEST(FileInput, ParseFile) {
+    const std::string path = "test_expr.txt";
+    write_file(path, "(1+x)*\n  y-4/z\n");
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse_file(path));
+    EXPECT_EQ("(BINOP:-(BINOP:*(BINOP:+(NUM:1)(ID:x))(ID:y))(BINOP:/(NUM:4)(ID:z)))", serialize(parser));
+
+    // empty files can't be mapped and are read instead
+    write_file(path, "");
+    SLR::InputFile file;
+    ASSERT_EQ(0, file.open(path));
+    EXPECT_FALSE(file.is_mapped());
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.parse_file(path));
+
+    EXPECT_EQ(ParseStatus::BAD_INPUT, parser.parse_file("no_such_file.txt"));
+    std::filesystem::remove(path);
+}
+
+// lines of stream_file_lines as "status serialized"
+static std::vector<std::string> stream_lines(const ParseTables& tables, const std::string& path, std::size_t window) {
+    std::vector<std::string> lines;
+    int error = stream_file_lines(tables, path, [&](std::size_t line, ParseStatus status, const std::string& tree) {
+        EXPECT_EQ(lines.size() + 1, line);
+        lines.push_back(std::to_string(int(status)) + " " + tree);
+    }, window, 2);
+    EXPECT_EQ(0, error);
+    return lines;
+}
+
+TEST(FileInput, StreamingMatchesWholeFile) {
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text += i % 7 == 3 ? "x+" : "(a" + std::to_string(i) + ")*b";
+        text += i % 5 ? "\n" : "\r\n";
+    }
+    text += "last";
+    const std::string path = "test_lines.txt";
+    write_file(path, text);
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    LineResults whole = parse_lines(tables, text, 1);
+    std::vector<std::string> expected;
+    for (std::size_t i = 0; i < whole.size(); i++) {
+        expected.push_back(std::to_string(int(whole.status[i])) + " " + whole.serialized[i]);
+    }
+
+    // windows smaller and larger than a page, and the whole file at once
+    for (std::size_t window: {std::size_t(16), std::size_t(5000), text.size() + 1}) {
+        EXPECT_EQ(expected, stream_lines(tables, path, window)) << window;
+    }
+
+    // line longer than the window is reported and skipped
+    write_file(path, "1+2\n" + std::string(100, 'a') + "*b\n3\n");
+    std::vector<std::string> lines = stream_lines(tables, path, 32);
+    ASSERT_EQ(3, lines.size());
+    EXPECT_EQ("0 (BINOP:+(NUM:1)(NUM:2))", lines[0]);
+    EXPECT_EQ(std::to_string(int(ParseStatus::BAD_INPUT)) + " <EMPTY_TREE>", lines[1]);
+    EXPECT_EQ("0 (NUM:3)", lines[2]);
+
+    EXPECT_EQ(-1, stream_file_lines(tables, "no_such_file.txt", [](auto...) {}));
+    std::filesystem::remove(path);
+}
+
+TEST(FileInput, StreamingFromPipe) {
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+
+    const std::string path = "test_pipe";
+    std::filesystem::remove(path);
+    ASSERT_EQ(0, mkfifo(path.c_str(), 0600));
+
+    std::string text;
+    for (int i = 0; i < 1000; i++) text += "x*(y+" + std::to_string(i) + ")\n";
+    text += std::string(64, 'z') + "\n1/2";
+
+    // pipe can't be mapped, so it is read through the window buffer
+    std::thread writer([&] { write_file(path, text); });
+    std::vector<std::string> lines = stream_lines(tables, path, 40);
+    writer.join();
+
+    ASSERT_EQ(1002, lines.size());
+    EXPECT_EQ("0 (BINOP:*(ID:x)(BINOP:+(ID:y)(NUM:999)))", lines[999]);
+    EXPECT_EQ(std::to_string(int(ParseStatus::BAD_INPUT)) + " <EMPTY_TREE>", lines[1000]);
+    EXPECT_EQ("0 (BINOP:/(NUM:1)(NUM:2))", lines[1001]);
+    std::filesystem::remove(path);
+}
+
+/* ======================== SYMBOL TABLE ========================== */
+
+TEST(SymbolTable, InterningInThreads) {
+    AST::SymbolTable table;
+    EXPECT_EQ(0, table.intern("x"));
+    EXPECT_EQ(1, table.intern("y"));
+    EXPECT_EQ(0, table.intern("x"));
+
+    // every thread interns the same names in a different order
+    std::vector<std::vector<std::uint32_t>> ids(4, std::vector<std::uint32_t>(300));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            AST::SymbolCache cache(table);
+            for (int i = 0; i < 300; i++) {
+                int name = t % 2 ? 299 - i : (i + t * 75) % 300;
+                ids[t][name] = cache.intern(keyword(name));
+            }
+        });
+    }
+    for (std::thread& thread: threads) thread.join();
+
+    EXPECT_EQ(302, table.size());
+    for (int name = 0; name < 300; name++) {
+        for (int t = 1; t < 4; t++) EXPECT_EQ(ids[0][name], ids[t][name]);
+        EXPECT_EQ(keyword(name), table.name(ids[0][name]));
+    }
+}
+
+TEST(SymbolTable, IdNodesShareNames) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("alpha*beta+alpha"));
+    EXPECT_EQ("(BINOP:+(BINOP:*(ID:alpha)(ID:beta))(ID:alpha))", serialize(parser));
+
+    auto sum = std::static_pointer_cast<AST::BinOpNode>(parser.get_root());
+    auto product = std::static_pointer_cast<AST::BinOpNode>(sum->left);
+    auto first = std::static_pointer_cast<AST::IdNode>(product->left);
+    auto second = std::static_pointer_cast<AST::IdNode>(product->right);
+    auto last = std::static_pointer_cast<AST::IdNode>(sum->right);
+
+    EXPECT_EQ(first->name_id, last->name_id);
+    EXPECT_NE(first->name_id, second->name_id);
+    EXPECT_EQ("beta", second->name());
+    EXPECT_EQ(AST::symbols().intern("alpha"), first->name_id);
+}
+
+/* ======================== PUSH PARSING ========================== */
+
+TEST(PushParsing, LexerChunksMatchDirectLexer) {
+    std::vector<std::string> inputs = {
+        "", "1+x*(y-42)/z", " \t 12 \t+ ab\n\ncd*3 \n", "x#y @ 7$", "99999999999*b",
+        std::string(40, 'a') + "+" + std::string(20, '7') + std::string(33, ' ') + "Zz",
+    };
+
+    for (const std::string& text: inputs) {
+        auto expected = lex_direct(text);
+
+        // one byte per chunk
+        PushLexer lexer;
+        lexer.restart();
+        std::vector<Token> tokens;
+        for (char c: text) {
+            lexer.feed(std::string_view(&c, 1));
+            while (lexer.next_tok()) tokens.push_back(lexer.cur_tok());
+        }
+        lexer.finish();
+        do {
+            ASSERT_TRUE(lexer.next_tok());
+            tokens.push_back(lexer.cur_tok());
+        } while (tokens.back().type_ != TokenType::END);
+
+        ASSERT_EQ(expected.size(), tokens.size()) << text;
+        for (std::size_t i = 0; i < tokens.size(); i++) {
+            EXPECT_EQ(expected[i].first.type_, tokens[i].type_) << text << " token " << i;
+            EXPECT_EQ(expected[i].second, tokens[i].lexeme(lexer.source())) << text << " token " << i;
+            EXPECT_EQ(expected[i].first.line_, tokens[i].line_) << text << " token " << i;
+            EXPECT_EQ(expected[i].first.pos_, tokens[i].pos_) << text << " token " << i;
+            EXPECT_EQ(expected[i].first.int_val, tokens[i].int_val) << text << " token " << i;
+        }
+    }
+}
+
+TEST(PushParsing, SourceLimit) {
+    // the run of letters passes the limit inside a chunk or when the next chunk continues it
+    for (std::vector<std::string> chunks: {std::vector<std::string>{"abc + defgh + i"},
+                                           std::vector<std::string>{"abc+de", "fgh+i"}}) {
+        PushLexer lexer;
+        lexer.set_source_limit(8);
+        lexer.restart();
+        std::vector<Token> tokens;
+        for (const std::string& chunk: chunks) {
+            lexer.feed(chunk);
+            while (lexer.next_tok()) {
+                tokens.push_back(lexer.cur_tok());
+                if (tokens.back().too_long) break;
+            }
+            if (!tokens.empty() && tokens.back().too_long) break;
+        }
+
+        ASSERT_EQ(3, tokens.size()) << chunks[0];
+        EXPECT_EQ("abc", tokens[0].lexeme(lexer.source()));
+        EXPECT_EQ("+", tokens[1].lexeme(lexer.source()));
+        EXPECT_TRUE(tokens[2].too_long);
+        EXPECT_EQ(TokenType::UNKNOWN, tokens[2].type_);
+        EXPECT_EQ(SymbolMap::error_symbol, tokens[2].symbol_);
+        EXPECT_LE(lexer.source().size(), 8);
+    }
+
+    // one character over the limit
+    PushLexer lexer;
+    lexer.set_source_limit(2);
+    lexer.restart();
+    lexer.feed("1+(");
+    ASSERT_TRUE(lexer.next_tok());
+    ASSERT_TRUE(lexer.next_tok());
+    EXPECT_FALSE(lexer.cur_tok().too_long);
+    ASSERT_TRUE(lexer.next_tok());
+    EXPECT_TRUE(lexer.cur_tok().too_long);
+    EXPECT_EQ("1+", lexer.source());
+}
+
+TEST(PushParsing, AnySplitMatchesParse) {
+    std::vector<std::string> inputs = {
+        "(1+xyz)*y-4/z", "alpha*(beta+4", "1+()", "x#y", "12 ab", "\n 7\t*\n(q)", "", "x*99999999999",
+    };
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser pull(tables), push(tables);
+    std::ostringstream pull_errors, push_errors;
+    pull.set_error_stream(&pull_errors);
+    push.set_error_stream(&push_errors);
+
+    for (const std::string& text: inputs) {
+        pull_errors.str("");
+        ParseStatus expected = pull.parse(text);
+        std::ostringstream expected_tree;
+        AST::dumpTreeAsString(pull.get_root(), expected_tree);
+
+        for (std::size_t split = 0; split <= text.size(); split++) {
+            push_errors.str("");
+            std::string first = text.substr(0, split), second = text.substr(split);
+            ParseStatus status = push.feed(first);
+            if (status == ParseStatus::INCOMPLETE) status = push.feed(second);
+            if (status != ParseStatus::INCOMPLETE) EXPECT_EQ(expected, status) << text << " at " << split;
+            EXPECT_EQ(expected, push.finish()) << text << " at " << split;
+
+            std::ostringstream tree;
+            AST::dumpTreeAsString(push.get_root(), tree);
+            EXPECT_EQ(expected_tree.str(), tree.str()) << text << " at " << split;
+            EXPECT_EQ(pull_errors.str(), push_errors.str()) << text << " at " << split;
+        }
+    }
+}
+
+TEST(PushParsing, StatusAcrossCalls) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("12"));
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("3*(ab"));
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("c)"));
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.finish());
+    EXPECT_EQ("(BINOP:*(NUM:123)(ID:abc))", serialize(parser));
+
+    // error is kept until finish(), the next feed() starts over
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.feed("1++"));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.feed("2"));
+    EXPECT_EQ(ParseStatus::SYNTAX_ERR, parser.finish());
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("x"));
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.finish());
+    EXPECT_EQ("(ID:x)", serialize(parser));
+
+    // pull parsing in between abandons the pushed input
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("x+"));
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse("7"));
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("y"));
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.finish());
+    EXPECT_EQ("(ID:y)", serialize(parser));
+}
+
+/* ======================== TOKEN BUFFER ========================== */
+
+TEST(TokenBuffer, SameResultsAsDirectLexer) {
+    std::vector<std::string> inputs = {
+        "(1+x)*y-4/z", "a*(b+4", "1+()", "x#y", "12 ab", "\n 7\t*\n(q)", "", "x*99999999999",
+    };
+
+    SyntaxAnalyzer tables;
+    ASSERT_EQ(0, tables.init());
+
+    for (TableLayout layout: {TableLayout::DENSE, TableLayout::COMPRESSED}) {
+        ASSERT_EQ(0, tables.set_table_layout(layout));
+        for (const std::string& text: inputs) {
+            std::ostringstream direct_errors, buffer_errors;
+            Parser direct_parser(tables), buffer_parser(tables);
+            buffer_parser.set_lexer_backend(Parser::LexerBackend::TOKEN_BUFFER);
+            direct_parser.set_error_stream(&direct_errors);
+            buffer_parser.set_error_stream(&buffer_errors);
+
+            EXPECT_EQ(direct_parser.parse(text), buffer_parser.parse(text)) << text;
+            EXPECT_EQ(direct_errors.str(), buffer_errors.str()) << text;
+
+            std::ostringstream direct_tree, buffer_tree;
+            AST::dumpTreeAsString(direct_parser.get_root(), direct_tree);
+            AST::dumpTreeAsString(buffer_parser.get_root(), buffer_tree);
+            EXPECT_EQ(direct_tree.str(), buffer_tree.str()) << text;
+        }
+    }
+}
+
+TEST(TokenBuffer, SeveralExpressions) {
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+
+    std::string text = "1+x (a*b) c++ 7";
+    std::string_view view = text;
+    TokenBuffer tokens;
+    tokens.clear(view);
+    tables.tokenize(view.substr(0, 3), tokens);
+    tables.tokenize(view.substr(4, 5), tokens);
+    tables.tokenize(view.substr(10, 3), tokens);
+    tables.tokenize(view.substr(14, 1), tokens);
+    EXPECT_EQ(16, tokens.size());
+    EXPECT_EQ("b", tokens.token(7).lexeme(tokens.source));
+
+    Parser parser(tables);
+    parser.set_error_stream(nullptr);
+    std::size_t pos = 0;
+    std::vector<std::string> trees;
+    for (int i = 0; i < 4; i++) {
+        ParseStatus status = parser.parse_tokens(tokens, pos);
+        EXPECT_EQ(i == 2 ? ParseStatus::SYNTAX_ERR : ParseStatus::SUCCESS, status);
+        std::ostringstream out;
+        AST::dumpTreeAsString(parser.get_root(), out);
+        trees.push_back(out.str());
+    }
+    EXPECT_EQ(tokens.size(), pos);
+    EXPECT_EQ((std::vector<std::string>{"(BINOP:+(NUM:1)(ID:x))", "(BINOP:*(ID:a)(ID:b))", "<EMPTY_TREE>", "(NUM:7)"}),
+              trees);
+}
+
+TEST(TokenBuffer, PipelinedLines) {
+    const std::vector<std::string> samples = {"1+x*y/2+4", "(x", "a*b/c*d", "x=y", "", "(((x)))+(y/(43-x))"};
+    std::string text;
+    for (int i = 0; i < 5000; i++) {
+        text += samples[i % samples.size()] + (i % 3 ? "+" + std::to_string(i) : "");
+        text += i % 7 ? "\n" : "\r\n";
+        // blocks are cut by size too, with longer lines in blocks of their own
+        if (i % 1000 == 999) {
+            for (int j = 0; j < (i / 1000 + 1) * 100000; j++) text += "x*2+";
+            text += "1\n";
+        }
+    }
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    LineResults expected = parse_lines(tables, text, 1);
+    LineResults results = parse_lines_pipelined(tables, text);
+    EXPECT_EQ(expected.status, results.status);
+    EXPECT_EQ(expected.serialized, results.serialized);
+
+    EXPECT_EQ(0, parse_lines_pipelined(tables, "").size());
+}
+
+/* ======================== ARENA AST ========================== */
+
+TEST(ArenaTree, DumpsMatchSharedTree) {
+    const std::vector<std::string> inputs = {"1+x*y/2+4", "(((x)))+(y/(43-x))", "a", "7", "1+()", "x#"};
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser shared(tables), arena(tables);
+    shared.set_error_stream(nullptr);
+    arena.set_error_stream(nullptr);
+    arena.set_ast_storage(Parser::AstStorage::ARENA);
+
+    for (const std::string& text: inputs) {
+        ParseStatus status = shared.parse(text);
+        EXPECT_EQ(status, arena.parse(text)) << text;
+        EXPECT_EQ(status != ParseStatus::SUCCESS, arena.get_tree().empty()) << text;
+
+        std::ostringstream shared_str, arena_str;
+        AST::dumpTreeAsString(shared.get_root(), shared_str);
+        AST::dumpTreeAsString(arena.get_tree(), arena_str);
+        EXPECT_EQ(shared_str.str(), arena_str.str()) << text;
+
+        // copies keep node ids, so Graphviz output is the same too
+        AST::Tree copy;
+        copy.root = AST::copy_to_tree(shared.get_root(), copy);
+        std::ostringstream shared_dot, copy_dot, back_dot;
+        AST::dumpTreeAsGraphviz(shared.get_root(), shared_dot);
+        AST::dumpTreeAsGraphviz(copy, copy_dot);
+        AST::dumpTreeAsGraphviz(AST::to_node(copy, copy.root), back_dot);
+        EXPECT_EQ(shared_dot.str(), copy_dot.str()) << text;
+        EXPECT_EQ(shared_dot.str(), back_dot.str()) << text;
+    }
+}
+
+TEST(ArenaTree, IndicesAndOwnership) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    parser.set_ast_storage(SyntaxAnalyzer::AstStorage::ARENA);
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("a-3*b"));
+    EXPECT_EQ(nullptr, parser.get_root());
+
+    // children are built before their parents
+    const AST::Tree& tree = parser.get_tree();
+    ASSERT_EQ(5, tree.size());
+    EXPECT_EQ(4, tree.root);
+    EXPECT_EQ(AST::no_node, tree[tree.root].parent);
+    for (AST::NodeIndex i = 0; i < tree.size(); i++) {
+        const AST::TreeNode& node = tree[i];
+        if (node.kind != AST::NodeKind::BINOP) continue;
+        EXPECT_LT(node.left, i);
+        EXPECT_LT(node.right, i);
+        EXPECT_EQ(i, tree[node.left].parent);
+        EXPECT_EQ(i, tree[node.right].parent);
+    }
+    EXPECT_EQ(AST::MINUS, tree[tree.root].op);
+    EXPECT_EQ("a", AST::symbols().name(tree[tree[tree.root].left].value));
+
+    // a taken tree outlives the next parse
+    Parser parser2(parser);
+    parser2.set_ast_storage(Parser::AstStorage::ARENA);
+    ASSERT_EQ(ParseStatus::SUCCESS, parser2.parse("(x)"));
+    AST::Tree kept = parser2.take_tree();
+    EXPECT_TRUE(parser2.get_tree().empty());
+    ASSERT_EQ(ParseStatus::SUCCESS, parser2.parse("y"));
+
+    std::ostringstream out;
+    AST::dumpTreeAsString(kept, out);
+    EXPECT_EQ("(ID:x)", out.str());
+}
+
+/* ======================== POSTFIX OUTPUT ========================== */
+
+TEST(PostfixOutput, MatchesTree) {
+    const std::vector<std::string> inputs = {"1+x*y/2+4", "(((x)))+(y/(43-x))", "a", "7", "1+()", "x#"};
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser shared(tables), postfix(tables);
+    shared.set_error_stream(nullptr);
+    postfix.set_error_stream(nullptr);
+    postfix.set_ast_storage(Parser::AstStorage::POSTFIX);
+
+    for (const std::string& text: inputs) {
+        ParseStatus status = shared.parse(text);
+        EXPECT_EQ(status, postfix.parse(text)) << text;
+        EXPECT_EQ(status != ParseStatus::SUCCESS, postfix.get_postfix().empty()) << text;
+
+        AST::Postfix converted;
+        AST::to_postfix(shared.get_root(), converted);
+        auto items = postfix.get_postfix();
+        ASSERT_EQ(converted.size(), items.size()) << text;
+        for (std::size_t i = 0; i < items.size(); i++) {
+            EXPECT_EQ(converted[i].opcode, items[i].opcode) << text << " item " << i;
+            EXPECT_EQ(converted[i].operand, items[i].operand) << text << " item " << i;
+        }
+
+        std::ostringstream shared_str, postfix_str;
+        AST::dumpTreeAsString(shared.get_root(), shared_str);
+        AST::dumpTreeAsString(AST::from_postfix(items), postfix_str);
+        EXPECT_EQ(shared_str.str(), postfix_str.str()) << text;
+    }
+}
+
+TEST(PostfixOutput, Records) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    parser.set_ast_storage(SyntaxAnalyzer::AstStorage::POSTFIX);
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("(1-b)*3"));
+
+    auto items = parser.get_postfix();
+    ASSERT_EQ(5, items.size());
+    EXPECT_EQ(AST::PostfixOp::NUM, items[0].opcode);
+    EXPECT_EQ(1, items[0].operand);
+    EXPECT_EQ(AST::PostfixOp::ID, items[1].opcode);
+    EXPECT_EQ("b", AST::symbols().name(items[1].operand));
+    EXPECT_EQ(AST::PostfixOp::BINOP, items[2].opcode);
+    EXPECT_EQ(AST::MINUS, items[2].operand);
+    EXPECT_EQ(AST::PostfixOp::NUM, items[3].opcode);
+    EXPECT_EQ(AST::PostfixOp::BINOP, items[4].opcode);
+    EXPECT_EQ(AST::MUL, items[4].operand);
+
+    // not one whole expression
+    EXPECT_EQ(nullptr, AST::from_postfix({}));
+    EXPECT_EQ(nullptr, AST::from_postfix(items.subspan(0, 2)));
+    EXPECT_EQ(nullptr, AST::from_postfix(items.subspan(1, 2)));
+
+    // operator out of range
+    std::vector<AST::PostfixItem> bad(items.begin(), items.end());
+    bad[2].operand = AST::DIV + 1;
+    EXPECT_EQ(nullptr, AST::from_postfix(bad));
+    bad[2].operand = -1;
+    EXPECT_EQ(nullptr, AST::from_postfix(bad));
+
+    // name id out of range
+    bad.assign(items.begin(), items.end());
+    bad[1].operand = std::int32_t(AST::symbols().size());
+    EXPECT_EQ(nullptr, AST::from_postfix(bad));
+    bad[1].operand = -1;
+    EXPECT_EQ(nullptr, AST::from_postfix(bad));
+}
+
+/* ======================== AST TRAVERSAL ========================== */
+
+TEST(AstTraversal, VisitAndFold) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("(7-x)*2+y/4"));
+    AST::NodePtr root = parser.get_root();
+
+    auto kind_name = AST::Overloaded{
+        [](const AST::BinOpNode&) { return "binop"; },
+        [](const AST::IdNode&) { return "id"; },
+        [](const AST::NumNode&) { return "num"; },
+    };
+    EXPECT_STREQ("binop", AST::visit(kind_name, *root));
+
+    // a new pass without touching node classes: count, depth and evaluation with x = 3, y = 8
+    auto count = AST::fold<int>(root, AST::Overloaded{
+        [](const AST::BinOpNode&, int left, int right) { return left + right + 1; },
+        [](const auto&) { return 1; },
+    });
+    auto depth = AST::fold<int>(root, AST::Overloaded{
+        [](const AST::BinOpNode&, int left, int right) { return std::max(left, right) + 1; },
+        [](const auto&) { return 1; },
+    });
+    auto value = AST::fold<int>(root, AST::Overloaded{
+        [](const AST::BinOpNode& node, int left, int right) {
+            switch (node.op) {
+                case AST::PLUS: return left + right;
+                case AST::MINUS: return left - right;
+                case AST::MUL: return left * right;
+                default: return left / right;
+            }
+        },
+        [](const AST::IdNode& node) { return node.name() == "x" ? 3 : 8; },
+        [](const AST::NumNode& node) { return node.num; },
+    });
+    EXPECT_EQ(9, count);
+    EXPECT_EQ(4, depth);
+    EXPECT_EQ(10, value);
+    EXPECT_EQ(0, AST::fold<int>(nullptr, [](const auto&...) { return 1; }));
+}
+
+TEST(AstTraversal, NullChildren) {
+    // hand-built trees may miss children, passes see them as null
+    AST::NodePtr root = AST::makeBinOp(AST::makeNum(1), AST::PLUS, nullptr);
+    EXPECT_EQ(2, AST::fold<int>(root, AST::Overloaded{
+        [](const AST::BinOpNode&, int left, int right) { return left + right + 1; },
+        [](const auto&) { return 1; },
+    }));
+
+    AST::Tree tree;
+    tree.root = AST::copy_to_tree(root, tree);
+    ASSERT_EQ(2, tree.size());
+    EXPECT_EQ(AST::no_node, tree[tree.root].right);
+    EXPECT_EQ(tree.root, tree[tree[tree.root].left].parent);
+
+    std::ostringstream shared_str, arena_str;
+    AST::dumpTreeAsString(root, shared_str);
+    AST::dumpTreeAsString(tree, arena_str);
+    EXPECT_EQ("(BINOP:+(NUM:1))", shared_str.str());
+    EXPECT_EQ(shared_str.str(), arena_str.str());
+}
+
+/* ======================== DEEP INPUTS ========================== */
+
+// counts characters without keeping them
+class CountingBuf : public std::streambuf {
+public:
+    std::size_t count = 0;
+protected:
+    int overflow(int c) override { count++; return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { count += n; return n; }
+};
+
+TEST(DeepInputs, NoNativeRecursion) {
+    const int n = 200000;
+    std::string nested = std::string(n, '(') + "x" + std::string(n, ')');
+    std::string chain = "a";
+    std::string right = "";
+    for (int i = 0; i < n; i++) {
+        chain += "+a";
+        right += "a-(";
+    }
+    right += "a" + std::string(n, ')');
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser parser(tables);
+
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse(nested));
+    EXPECT_EQ(1, AST::fold<int>(parser.get_root(), [](const auto&, auto...) { return 1; }));
+
+    for (const std::string* text: {&chain, &right}) {
+        ASSERT_EQ(ParseStatus::SUCCESS, parser.parse(*text));
+        AST::NodePtr root = parser.get_root();
+        int depth = AST::fold<int>(root, AST::Overloaded{
+            [](const AST::BinOpNode&, int left, int right) { return std::max(left, right) + 1; },
+            [](const auto&) { return 1; },
+        });
+        EXPECT_EQ(n + 1, depth);
+
+        CountingBuf buf;
+        std::ostream out(&buf);
+        AST::dumpTreeAsString(root, out);
+        EXPECT_EQ(std::size_t(n) * 9 + (n + 1) * 6, buf.count); // "(BINOP:+" ")" and "(ID:a)"
+        AST::dumpTreeAsGraphviz(root, out);
+
+        AST::Postfix postfix;
+        AST::to_postfix(root, postfix);
+        EXPECT_EQ(std::size_t(2 * n + 1), postfix.size());
+        AST::NodePtr copy = AST::from_postfix(postfix);
+
+        AST::Tree tree;
+        tree.root = AST::copy_to_tree(root, tree);
+        AST::dumpTreeAsString(tree, out);
+        AST::dumpTreeAsGraphviz(tree, out);
+        AST::NodePtr back = AST::to_node(tree, tree.root);
+        // root, copy and back are freed here, each a chain of 200000 nodes
+    }
+}
+
+TEST(DeepInputs, Limits) {
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser parser(tables);
+    std::ostringstream errors;
+    parser.set_error_stream(&errors);
+    parser.set_limits({.max_tokens = 6, .max_depth = 8});
+
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse("1+2*3"));
+    EXPECT_EQ(ParseStatus::BAD_INPUT, parser.parse("1+2*3-4"));
+    EXPECT_EQ("Expression is too long: more than 6 tokens\n", errors.str());
+    EXPECT_EQ(nullptr, parser.get_root());
+
+    errors.str("");
+    parser.set_limits({.max_depth = 8});
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse("((((x))))"));
+    EXPECT_EQ(ParseStatus::BAD_INPUT, parser.parse("(((((((((x)))))))))"));
+    EXPECT_EQ("Expression is nested too deeply at 1:7: more than 8 parse stack entries\n", errors.str());
+    // left-leaning chains don't grow the stack
+    EXPECT_EQ(ParseStatus::SUCCESS, parser.parse("a+a+a+a+a+a+a+a+a+a+a+a+a+a"));
+
+    // the same in push parsing
+    EXPECT_EQ(ParseStatus::INCOMPLETE, parser.feed("(((((("));
+    EXPECT_EQ(ParseStatus::BAD_INPUT, parser.feed("((("));
+    EXPECT_EQ(ParseStatus::BAD_INPUT, parser.finish());
+}
+
+/* ======================== SHARED SUBTREES ========================== */
+
+TEST(DagBuilder, SharesIdenticalSubtrees) {
+    AST::DagBuilder dag;
+    AST::NodePtr sum1 = dag.makeBinOp(dag.makeId("x"), AST::PLUS, dag.makeNum(1));
+    AST::NodePtr sum2 = dag.makeBinOp(dag.makeId("x"), AST::PLUS, dag.makeNum(1));
+    AST::NodePtr product = dag.makeBinOp(sum1, AST::MUL, sum2);
+    EXPECT_EQ(sum1, sum2);
+    EXPECT_EQ(4, dag.size());
+    EXPECT_EQ(7, dag.requested());
+    EXPECT_NE(sum1, dag.makeBinOp(dag.makeNum(1), AST::PLUS, dag.makeId("x")));
+
+    // structural hashes and equality don't depend on the builder
+    AST::NodePtr tree = AST::makeBinOp(AST::makeBinOp(AST::makeId("x"), AST::PLUS, AST::makeNum(1)), AST::MUL,
+                                       AST::makeBinOp(AST::makeId("x"), AST::PLUS, AST::makeNum(1)));
+    EXPECT_EQ(tree->hash, product->hash);
+    EXPECT_TRUE(AST::equal(tree, product));
+    EXPECT_FALSE(AST::equal(tree, sum1));
+    EXPECT_FALSE(AST::equal(tree, nullptr));
+    EXPECT_TRUE(AST::equal(nullptr, nullptr));
+
+    std::ostringstream tree_str, dag_str;
+    AST::dumpTreeAsString(tree, tree_str);
+    AST::dumpTreeAsString(product, dag_str);
+    EXPECT_EQ(tree_str.str(), dag_str.str());
+
+    // the shared sum has one parent, referenced on both sides
+    AST::ParentMap parents(product);
+    EXPECT_EQ(4, parents.size());
+    EXPECT_TRUE(parents.of(*product).empty());
+    ASSERT_EQ(1, parents.of(*sum1).size());
+    EXPECT_EQ(product.get(), parents.of(*sum1)[0]);
+
+    AST::ParentMap tree_parents(tree);
+    EXPECT_EQ(7, tree_parents.size());
+    auto left = static_cast<const AST::BinOpNode&>(*tree).left;
+    EXPECT_EQ(tree.get(), tree_parents.of(*left)[0]);
+}
+
+TEST(DagBuilder, ParserMode) {
+    const std::vector<std::string> inputs = {"(a+1)*(a+1)", "a+1", "x*y/(a+1)-(x*y)", "1+()", "7"};
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser shared(tables), dag(tables);
+    shared.set_error_stream(nullptr);
+    dag.set_error_stream(nullptr);
+    dag.set_ast_storage(Parser::AstStorage::DAG);
+
+    std::vector<AST::NodePtr> roots;
+    for (const std::string& text: inputs) {
+        EXPECT_EQ(shared.parse(text), dag.parse(text)) << text;
+        EXPECT_TRUE(AST::equal(shared.get_root(), dag.get_root())) << text;
+
+        std::ostringstream shared_str, dag_str;
+        AST::dumpTreeAsString(shared.get_root(), shared_str);
+        AST::dumpTreeAsString(dag.get_root(), dag_str);
+        EXPECT_EQ(shared_str.str(), dag_str.str()) << text;
+        roots.push_back(dag.get_root());
+    }
+
+    // "a+1" of the second expression is the node built for the first one
+    EXPECT_EQ(static_cast<const AST::BinOpNode&>(*roots[0]).left, roots[1]);
+    EXPECT_LT(dag.get_dag_builder().size(), dag.get_dag_builder().requested());
+}
+
+/* ======================== BINARY FORMAT ========================== */
+
+static std::string serialize(const AST::NodePtr& root) {
+    std::ostringstream out;
+    AST::dumpTreeAsString(root, out);
+    return out.str();
+}
+
+TEST(BinaryFormat, RoundTrip) {
+    std::vector<std::string> inputs = {"1+x*y/2+4", "(((x)))+(y/(43-x))", "a", "7", "2147483647*x-x", "1+()"};
+    inputs.push_back(std::string(5000, '(') + "1" + std::string(5000, ')'));
+    std::string chain = "v";
+    for (int i = 0; i < 2000; i++) chain += "-v" + std::to_string(i % 300) + "*" + std::to_string(i * 1117);
+    inputs.push_back(chain);
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser parser(tables);
+    parser.set_error_stream(nullptr);
+    for (const std::string& text: inputs) {
+        parser.parse(text);
+        std::vector<std::uint8_t> bytes;
+        AST::write_binary(parser.get_root(), bytes);
+
+        AST::BinaryReader reader;
+        ASSERT_EQ(0, reader.open(bytes)) << text;
+        std::ostringstream binary_str;
+        AST::dumpTreeAsString(reader, binary_str);
+        EXPECT_EQ(serialize(parser.get_root()), binary_str.str()) << text;
+        EXPECT_TRUE(AST::equal(parser.get_root(), reader.to_node())) << text;
+    }
+
+    // values the parser doesn't produce and null children
+    AST::NodePtr odd = AST::makeBinOp(AST::makeNum(-5), AST::DIV,
+                                      AST::makeBinOp(nullptr, AST::MINUS, AST::makeNum(INT32_MIN)));
+    std::vector<std::uint8_t> bytes;
+    AST::write_binary(odd, bytes);
+    AST::BinaryReader reader;
+    ASSERT_EQ(0, reader.open(bytes));
+    EXPECT_EQ(4, reader.size());
+    EXPECT_TRUE(AST::equal(odd, reader.to_node()));
+    std::ostringstream binary_str;
+    AST::dumpTreeAsString(reader, binary_str);
+    EXPECT_EQ(serialize(odd), binary_str.str());
+}
+
+TEST(BinaryFormat, CompactAndChecked) {
+    AST::NodePtr root = AST::makeBinOp(AST::makeBinOp(AST::makeId("alpha"), AST::PLUS, AST::makeNum(1)), AST::MUL,
+                                       AST::makeBinOp(AST::makeId("alpha"), AST::MINUS, AST::makeNum(300)));
+    std::vector<std::uint8_t> bytes;
+    ASSERT_EQ(0, AST::write_binary(root, bytes));
+    // header, 7 opcodes, operands 1+1+1+2, one name of 5 letters
+    EXPECT_EQ(5 + 7 + 5 + 1 + 6, bytes.size());
+
+    // names are read in place
+    AST::BinaryReader reader;
+    ASSERT_EQ(0, reader.open(bytes));
+    std::vector<std::string_view> names;
+    reader.walk([&](const AST::BinaryNode& node) { if (node.kind == AST::NodeKind::ID) names.push_back(node.name); },
+                [](const AST::BinaryNode&, AST::Side) {});
+    ASSERT_EQ(2, names.size());
+    EXPECT_EQ("alpha", names[0]);
+    EXPECT_GE(names[0].data(), reinterpret_cast<const char*>(bytes.data()));
+    EXPECT_LT(names[0].data(), reinterpret_cast<const char*>(bytes.data() + bytes.size()));
+
+    std::vector<std::uint8_t> empty;
+    AST::write_binary(nullptr, empty);
+    ASSERT_EQ(0, reader.open(empty));
+    EXPECT_TRUE(reader.empty());
+    EXPECT_EQ(nullptr, reader.to_node());
+
+    // every truncation and a few corruptions are rejected
+    std::streambuf *old_err = std::cerr.rdbuf(nullptr);
+    for (std::size_t size = 0; size < bytes.size(); size++) {
+        EXPECT_NE(0, reader.open(std::span(bytes.data(), size))) << size;
+    }
+    auto corrupt = [&](std::size_t at, std::uint8_t byte) {
+        std::vector<std::uint8_t> copy = bytes;
+        copy[at] = byte;
+        return reader.open(copy);
+    };
+    EXPECT_NE(0, corrupt(0, 'X'));   // magic
+    EXPECT_NE(0, corrupt(4, 2));     // version
+    EXPECT_NE(0, corrupt(5, 0x7f));  // opcode
+    EXPECT_NE(0, corrupt(8, 0x01));  // name index 1 of 1 name
+    bytes.push_back(0);
+    EXPECT_NE(0, reader.open(bytes));
+
+    // an operator that would be read back as another opcode is not written
+    std::vector<std::uint8_t> appended = {1, 2};
+    AST::NodePtr odd = AST::makeBinOp(AST::makeNum(1), AST::Operator(std::uint8_t(AST::BinaryOp::ID)), AST::makeNum(2));
+    EXPECT_NE(0, AST::write_binary(AST::makeBinOp(AST::makeId("x"), AST::PLUS, odd), appended));
+    EXPECT_EQ((std::vector<std::uint8_t>{1, 2}), appended);
+    std::cerr.rdbuf(old_err);
+}
+
+/* ======================== BUFFERED TEXT OUTPUT ========================== */
+
+TEST(TextWriter, SameTextAsDumps) {
+    std::vector<std::string> inputs = {"1+x*y/2+4", "(((x)))+(y/(43-x))", "a", "2147483647", "1+()"};
+    inputs.push_back(std::string(3000, '(') + "long_name" + std::string(3000, ')') + "-1");
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser parser(tables);
+    parser.set_error_stream(nullptr);
+    std::vector<AST::NodePtr> roots;
+    for (const std::string& text: inputs) {
+        parser.parse(text);
+        roots.push_back(parser.get_root());
+    }
+    roots.push_back(AST::makeBinOp(AST::makeNum(-7), AST::Operator(9), nullptr));
+
+    AST::TextWriter writer;
+    for (AST::DumpType type: {AST::SERIALIZE, AST::GRAPHVIZ}) {
+        for (const AST::NodePtr& root: roots) {
+            std::ostringstream dump;
+            if (type == AST::SERIALIZE) AST::dumpTreeAsString(root, dump);
+            else AST::dumpTreeAsGraphviz(root, dump);
+
+            writer.clear();
+            writer.write(root, type);
+            EXPECT_EQ(dump.str(), writer.view());
+
+            AST::Tree tree;
+            tree.root = AST::copy_to_tree(root, tree);
+            writer.clear();
+            writer.write(tree, type);
+            EXPECT_EQ(dump.str(), writer.view());
+        }
+    }
+
+    writer.clear();
+    writer.append("Line ");
+    writer.append_number(-12345678901);
+    writer.append(':');
+    EXPECT_EQ("Line -12345678901:", writer.view());
+}
+
+TEST(TextWriter, FlushesInBlocks) {
+    // counts separate writes reaching the stream
+    class BlockBuf : public std::streambuf {
+    public:
+        std::string text;
+        std::size_t writes = 0;
+    protected:
+        int overflow(int c) override { text += char(c); writes++; return c; }
+        std::streamsize xsputn(const char *s, std::streamsize n) override { text.append(s, n); writes++; return n; }
+    };
+
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("(a+b)*c-12/d"));
+    std::ostringstream one;
+    AST::dumpTreeAsString(parser.get_root(), one);
+
+    BlockBuf buf;
+    std::ostream out(&buf);
+    std::string expected;
+    {
+        AST::TextWriter writer(&out, 4096);
+        for (int i = 0; i < 1000; i++) {
+            writer.write(parser.get_root(), AST::SERIALIZE);
+            writer.append('\n');
+            expected += one.str() + "\n";
+        }
+        EXPECT_LT(writer.view().size(), 4096 + one.str().size());
+    }
+    EXPECT_EQ(expected, buf.text);
+    EXPECT_LE(buf.writes, expected.size() / 4096 + 1);
+}
+
+/* ======================== BYTECODE EVALUATION ========================== */
+
+// tree-walking evaluation with the evaluator's arithmetic, nullopt on division by zero
+static std::optional<std::int32_t> evaluate_tree(const AST::NodePtr& root, const std::map<std::string, int>& vars) {
+    return AST::fold<std::optional<std::int32_t>>(root, AST::Overloaded{
+        [&](const AST::BinOpNode& binop, std::optional<std::int32_t> left,
+            std::optional<std::int32_t> right) -> std::optional<std::int32_t> {
+            if (!left || !right) return std::nullopt;
+            std::uint32_t l = *left, r = *right;
+            switch (binop.op) {
+                case AST::PLUS: return std::int32_t(l + r);
+                case AST::MINUS: return std::int32_t(l - r);
+                case AST::MUL: return std::int32_t(l * r);
+                default:
+                    if (r == 0) return std::nullopt;
+                    return *right == -1 ? std::int32_t(0u - l) : *left / *right;
+            }
+        },
+        [&](const AST::IdNode& id) -> std::optional<std::int32_t> { return vars.at(std::string(id.name())); },
+        [&](const AST::NumNode& num) -> std::optional<std::int32_t> { return num.num; },
+    });
+}
+
+TEST(Bytecode, MatchesTreeEvaluation) {
+    std::vector<std::string> inputs = {
+        "1+x*y/2+4", "(((x)))+(y/(43-x))", "a", "7", "2*3+4*5", "x/y", "7/y", "(x-1)/(y+2)", "7-x", "7-(x*y)",
+        "1/(x-x)", "2147483647*y-x+2147483647", "y/(2-2)", "(4-6)/(x*2)", "a*b-c/d+(a-d)*(b-c)", "x/(x/x)",
+    };
+    std::string chain = "v";
+    for (int i = 0; i < 20000; i++) chain += std::string("-v") + char('a' + i % 7) + "*" + std::to_string(i % 13);
+    inputs.push_back(chain);
+
+    const std::vector<int> samples = {0, 1, -1, 2, 3, 17, -40, 100000, INT32_MAX, INT32_MIN};
+
+    ParseTables tables;
+    ASSERT_EQ(0, tables.init());
+    Parser parser(tables);
+    AST::Evaluator evaluator;
+    evaluator.set_error_stream(nullptr);
+    for (const std::string& text: inputs) {
+        ASSERT_EQ(ParseStatus::SUCCESS, parser.parse(text)) << text;
+        AST::Program program;
+        ASSERT_EQ(0, AST::compile(parser.get_root(), program)) << text;
+
+        for (std::size_t k = 0; k < samples.size() * 3; k++) {
+            std::map<std::string, int> vars;
+            std::vector<std::int32_t> values(program.slots());
+            for (std::uint32_t slot = 0; slot < program.slots(); slot++) {
+                values[slot] = samples[(k + slot * (k / samples.size() + 1)) % samples.size()];
+                vars[std::string(program.slot_name(slot))] = values[slot];
+            }
+
+            std::optional<std::int32_t> expected = evaluate_tree(parser.get_root(), vars);
+            std::int32_t result = 0;
+            auto status = evaluator.run(program, values, result);
+            if (expected) {
+                ASSERT_EQ(AST::Evaluator::Status::SUCCESS, status) << text;
+                EXPECT_EQ(*expected, result) << text;
+            } else {
+                EXPECT_EQ(AST::Evaluator::Status::DIV_BY_ZERO, status) << text;
+            }
+        }
+    }
+}
+
+TEST(Bytecode, ProgramAndErrors) {
+    SyntaxAnalyzer parser;
+    ASSERT_EQ(0, parser.init());
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("(2*3-1)*x+y/x-x"));
+    AST::Program program;
+    ASSERT_EQ(0, AST::compile(parser.get_root(), program));
+
+    // constant part is folded, the variable used twice has one slot
+    ASSERT_EQ(2, program.slots());
+    EXPECT_EQ(0, program.slot("x"));
+    EXPECT_EQ(1, program.slot("y"));
+    EXPECT_EQ(AST::Program::no_slot, program.slot("z"));
+    auto code = program.instructions();
+    ASSERT_EQ(7, code.size());
+    EXPECT_EQ(AST::OpCode::PUSH_CONST, code[0].op);
+    EXPECT_EQ(5, code[0].operand);
+    EXPECT_EQ(AST::OpCode::MUL_VAR, code[1].op);
+    EXPECT_EQ(AST::OpCode::PUSH_VAR, code[2].op);
+    EXPECT_EQ(AST::OpCode::DIV_VAR, code[3].op);
+    EXPECT_EQ(AST::OpCode::ADD, code[4].op);
+    EXPECT_EQ(AST::OpCode::SUB_VAR, code[5].op);
+    EXPECT_EQ(AST::OpCode::RETURN, code[6].op);
+    EXPECT_EQ(2, program.stack_size());
+
+    std::ostringstream errors;
+    AST::Evaluator evaluator;
+    evaluator.set_error_stream(&errors);
+    std::int32_t result = 0;
+    const std::int32_t values[] = {4, 9};
+    ASSERT_EQ(AST::Evaluator::Status::SUCCESS, evaluator.run(program, values, result));
+    EXPECT_EQ(18, result);
+
+    const std::int32_t zero_x[] = {0, 9};
+    EXPECT_EQ(AST::Evaluator::Status::DIV_BY_ZERO, evaluator.run(program, zero_x, result));
+    EXPECT_EQ("Division by zero: 9 / x, x = 0\n", errors.str());
+    errors.str("");
+    EXPECT_EQ(AST::Evaluator::Status::BAD_BINDINGS, evaluator.run(program, std::span(values, 1), result));
+    EXPECT_EQ("Expression has 2 variables, 1 values given\n", errors.str());
+
+    // a zero divisor known at compile time is still reported when run
+    ASSERT_EQ(ParseStatus::SUCCESS, parser.parse("7/(3-3)"));
+    ASSERT_EQ(0, AST::compile(parser.get_root(), program));
+    errors.str("");
+    EXPECT_EQ(AST::Evaluator::Status::DIV_BY_ZERO, evaluator.run(program, {}, result));
+    EXPECT_EQ("Division by zero: 7 / 0\n", errors.str());
+
+    std::streambuf *old_err = std::cerr.rdbuf(nullptr);
+    EXPECT_NE(0, AST::compile(nullptr, program));
+    EXPECT_NE(0, AST::compile(AST::makeBinOp(AST::makeNum(1), AST::PLUS, nullptr), program));
+    EXPECT_NE(0, AST::compile(AST::makeBinOp(AST::makeNum(1), AST::Operator(AST::DIV + 1), AST::makeNum(2)), program));
+    EXPECT_EQ(0, program.instructions().size());
+    std::cerr.rdbuf(old_err);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
 
@@ -0,0 +1,45 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "syntax_analyzer.hpp"
+
+// Builds action/goto tables for the built-in grammar (or grammar from BNF file)
+// and writes them in binary format, loadable with SyntaxAnalyzer::init_from_file()
+int main(int argc, char* argv[]) {
+    auto lookahead = SyntaxAnalyzer::Lookahead::SLR;
+    if (argc > 1 && std::string(argv[1]) == "--lalr") {
+        lookahead = SyntaxAnalyzer::Lookahead::LALR;
+        argc--;
+        argv++;
+    }
+
+    if (argc < 2 || argc > 3 || std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
+        std::cerr << "Usage: slr-tablegen [--lalr] OUTPUT_FILE [GRAMMAR_FILE]\n";
+        return EXIT_FAILURE;
+    }
+
+    SyntaxAnalyzer parser;
+    if (argc == 3 && parser.load_grammar(argv[2])) {
+        return EXIT_FAILURE;
+    }
+
+    int conflicts = parser.init(SyntaxAnalyzer::TableSource::RUNTIME, lookahead);
+    const SyntaxAnalyzer::TableStats& stats = parser.table_stats();
+    if (conflicts < 0) {
+        return EXIT_FAILURE;
+    }
+    if (conflicts) {
+        std::cerr << "Grammar has " << stats.conflicts() << " conflicts ("
+                  << stats.shift_reduce << " shift/reduce, " << stats.reduce_reduce
+                  << " reduce/reduce), tables are not written\n";
+        return EXIT_FAILURE;
+    }
+
+    if (parser.export_binary_tables(argv[1])) {
+        std::cerr << "Failed to write tables to '" << argv[1] << "'\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}